@@ -0,0 +1,274 @@
+// Micro-benchmarks of the collision, easing and random kernels, of the batch collision kernels at each SIMD level, and of the whole update at several particle counts.
+// Reports the time and the amount of data processed per operation, and can write them as JSON to track regressions between releases.
+//
+// Usage: Particles-kernels-benchmark [--json output.json] [--filter substring]
+// An operation is one call of the kernel, or the update of one particle.
+// Bytes per operation is the size of the data the operation reads and writes, not counting the obstacles (which stay in the cache).
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "scene.hpp"
+#include "simulation/ColliderBVH.hpp"
+#include "simulation/ParticleSystem.hpp"
+#include "simulation/collision.hpp"
+#include "simulation/collision_batch.hpp"
+#include "simulation/easing.hpp"
+#include "simulation/random.hpp"
+#include "simulation/simd.hpp"
+#include "simulation/update.hpp"
+
+namespace {
+
+/// Prevents the compiler from optimizing away the computation of `value`
+template<typename T>
+void do_not_optimize(T const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static T volatile sink{};
+    sink = value;
+#endif
+}
+
+struct Result {
+    std::string name;
+    double      ns_per_op;
+    double      bytes_per_op;
+    size_t      ops_count; /// Per repetition
+};
+
+/// Calls `run_batch()`, which performs `ops_per_batch` operations, until it has run for long enough to be measured reliably.
+/// Repeats that a few times and keeps the median, which is less sensitive than the mean to the hiccups of the machine.
+template<typename Fn>
+auto measure(std::string name, size_t ops_per_batch, double bytes_per_op, Fn&& run_batch) -> Result
+{
+    using clock = std::chrono::steady_clock;
+
+    run_batch(); // Warm-up
+
+    // Find how many batches take at least 50ms
+    size_t batches_count = 1;
+    while (true)
+    {
+        auto const start = clock::now();
+        for (size_t i = 0; i < batches_count; ++i)
+            run_batch();
+        if (clock::now() - start >= std::chrono::milliseconds{50})
+            break;
+        batches_count *= 2;
+    }
+
+    auto timings = std::vector<double>{};
+    for (int repetition = 0; repetition < 5; ++repetition)
+    {
+        auto const start = clock::now();
+        for (size_t i = 0; i < batches_count; ++i)
+            run_batch();
+        auto const end = clock::now();
+        timings.push_back(std::chrono::duration<double, std::nano>{end - start}.count());
+    }
+    std::nth_element(timings.begin(), timings.begin() + timings.size() / 2, timings.end());
+
+    size_t const ops_count = batches_count * ops_per_batch;
+    return Result{
+        .name         = std::move(name),
+        .ns_per_op    = timings[timings.size() / 2] / static_cast<double>(ops_count),
+        .bytes_per_op = bytes_per_op,
+        .ops_count    = ops_count,
+    };
+}
+
+/// Collects the results of the benchmarks whose name contains `filter`, and skips the others.
+struct Suite {
+    std::string_view    filter{};
+    std::vector<Result> results{};
+
+    auto is_selected(std::string_view name) const -> bool { return name.find(filter) != std::string_view::npos; }
+
+    template<typename Fn>
+    void run(std::string name, size_t ops_per_batch, double bytes_per_op, Fn&& run_batch)
+    {
+        if (is_selected(name))
+            results.push_back(measure(std::move(name), ops_per_batch, bytes_per_op, std::forward<Fn>(run_batch)));
+    }
+};
+
+/// Small enough to stay in the L1 cache, so that the kernels are measured rather than the memory
+constexpr size_t inputs_count = 1024;
+
+auto random_points() -> std::vector<glm::vec2>
+{
+    auto points = std::vector<glm::vec2>(inputs_count);
+    for (auto& p : points)
+        p = {sim::rand(-1.f, 1.f), sim::rand(-1.f, 1.f)};
+    return points;
+}
+
+auto random_floats(float min, float max) -> std::vector<float>
+{
+    auto values = std::vector<float>(inputs_count);
+    for (auto& v : values)
+        v = sim::rand(min, max);
+    return values;
+}
+
+void run_kernels(Suite& suite)
+{
+    auto const p1 = random_points();
+    auto const p2 = random_points();
+    auto const q1 = random_points();
+    auto const q2 = random_points();
+    auto const ts = random_floats(0.f, 1.f);
+    auto const rs = random_floats(0.05f, 0.5f);
+
+    suite.run("segment_intersect", inputs_count, 4 * sizeof(glm::vec2) + sizeof(glm::vec2), [&]() {
+        for (size_t i = 0; i < inputs_count; ++i)
+        {
+            glm::vec2 intersection;
+            bool const hit = sim::segment_intersect(p1[i], p2[i], q1[i], q2[i], intersection);
+            do_not_optimize(hit);
+            do_not_optimize(intersection);
+        }
+    });
+    suite.run("segment_circle_intersect", inputs_count, 3 * sizeof(glm::vec2) + sizeof(float) + sizeof(glm::vec2), [&]() {
+        for (size_t i = 0; i < inputs_count; ++i)
+        {
+            glm::vec2 intersection;
+            bool const hit = sim::segment_circle_intersect(p1[i], p2[i], q1[i], rs[i], intersection);
+            do_not_optimize(hit);
+            do_not_optimize(intersection);
+        }
+    });
+    suite.run("bounce", inputs_count, 2 * sizeof(float), [&]() {
+        for (size_t i = 0; i < inputs_count; ++i)
+            do_not_optimize(sim::bounce(ts[i]));
+    });
+    suite.run("ease_in_out_power", inputs_count, 2 * sizeof(float), [&]() {
+        for (size_t i = 0; i < inputs_count; ++i)
+            do_not_optimize(sim::ease_in_out_power(ts[i], 3.f));
+    });
+    suite.run("rand", inputs_count, sizeof(float), [&]() {
+        for (size_t i = 0; i < inputs_count; ++i)
+            do_not_optimize(sim::rand(0.f, 1.f));
+    });
+}
+
+/// The batch kernels at each SIMD level the CPU supports, on batches of 16 paths. Reads a path and writes an intersection point per operation.
+void run_batch_kernels(Suite& suite)
+{
+    auto const start_x = random_floats(-1.f, 1.f);
+    auto const start_y = random_floats(-1.f, 1.f);
+    auto const end_x   = random_floats(-1.f, 1.f);
+    auto const end_y   = random_floats(-1.f, 1.f);
+    auto const segment = sim::Segment{{-0.5f, -0.2f}, {0.4f, 0.3f}};
+    auto const circle  = sim::Circle{{0.1f, -0.1f}, 0.3f};
+
+    constexpr size_t batch_size = 16;
+    auto             x          = std::array<float, batch_size>{};
+    auto             y          = std::array<float, batch_size>{};
+    for (int level = 0; level <= static_cast<int>(sim::detected_simd_level()); ++level)
+    {
+        sim::set_simd_level(static_cast<sim::SimdLevel>(level));
+        auto const level_name = std::string{sim::to_string(sim::simd_level())};
+        suite.run("segment_intersect_batch/" + level_name, inputs_count, 6 * sizeof(float), [&]() {
+            for (size_t i = 0; i < inputs_count; i += batch_size)
+                do_not_optimize(sim::segment_intersect_batch({&start_x[i], &start_y[i], &end_x[i], &end_y[i]}, batch_size, segment, x.data(), y.data()));
+        });
+        suite.run("segment_circle_intersect_batch/" + level_name, inputs_count, 6 * sizeof(float), [&]() {
+            for (size_t i = 0; i < inputs_count; i += batch_size)
+                do_not_optimize(sim::segment_circle_intersect_batch({&start_x[i], &start_y[i], &end_x[i], &end_y[i]}, batch_size, circle, x.data(), y.data()));
+        });
+    }
+    sim::set_simd_level(sim::detected_simd_level());
+}
+
+void run_update(Suite& suite, size_t particles_count)
+{
+    auto const name = "update_particles/" + std::to_string(particles_count);
+    if (!suite.is_selected(name))
+        return;
+
+    auto const colliders = sim::ColliderBVH{bench::star_obstacles()};
+    auto       particles = sim::ParticleSystem{particles_count};
+    for (size_t i = 0; i < particles_count; ++i)
+        particles.spawn(sim::random_particle(bench::aspect_ratio));
+
+    // Reads position, velocity and age; writes them back along with the previous position
+    constexpr double bytes_per_particle = (5 + 7) * sizeof(float);
+    suite.run(name, particles_count, bytes_per_particle, [&]() {
+        sim::update_particles(particles, colliders, bench::dt);
+    });
+}
+
+void print_table(std::vector<Result> const& results)
+{
+    std::printf("%-36s %12s %12s %10s\n", "benchmark", "ns/op", "bytes/op", "GB/s");
+    for (auto const& result : results)
+        std::printf("%-36s %12.3f %12.1f %10.2f\n", result.name.c_str(), result.ns_per_op, result.bytes_per_op, result.bytes_per_op / result.ns_per_op);
+}
+
+auto write_json(std::vector<Result> const& results, char const* path) -> bool
+{
+    std::FILE* file = std::fopen(path, "w");
+    if (file == nullptr)
+        return false;
+    std::fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto const& result = results[i];
+        std::fprintf(
+            file, "    {\"name\": \"%s\", \"ns_per_op\": %.4f, \"bytes_per_op\": %.1f, \"ops\": %zu}%s\n",
+            result.name.c_str(), result.ns_per_op, result.bytes_per_op, result.ops_count, i + 1 < results.size() ? "," : ""
+        );
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+[[noreturn]] void exit_with_usage(char const* program_name)
+{
+    std::fprintf(stderr, "Usage: %s [--json output.json] [--filter substring]\n", program_name);
+    std::exit(EXIT_FAILURE);
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    char const* json_path = nullptr;
+    auto        suite     = Suite{};
+    for (int i = 1; i < argc; i += 2)
+    {
+        auto const arg = std::string_view{argv[i]};
+        if (i + 1 == argc)
+            exit_with_usage(argv[0]);
+        if (arg == "--json")
+            json_path = argv[i + 1];
+        else if (arg == "--filter")
+            suite.filter = argv[i + 1];
+        else
+            exit_with_usage(argv[0]);
+    }
+
+    sim::seed_random(0); // Always benchmark the same inputs
+
+    run_kernels(suite);
+    run_batch_kernels(suite);
+    for (size_t const count : {1'000, 10'000, 100'000, 1'000'000})
+        run_update(suite, count);
+
+    print_table(suite.results);
+    if (json_path != nullptr && !write_json(suite.results, json_path))
+    {
+        std::fprintf(stderr, "Could not write %s\n", json_path);
+        return EXIT_FAILURE;
+    }
+}
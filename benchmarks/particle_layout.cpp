@@ -0,0 +1,112 @@
+// Compares the update of particles stored as an array of structs (std::vector<sim::Particle>, what the app used to do)
+// with the same update on a sim::ParticleSystem, which stores each attribute in its own column.
+//
+// Usage: Particles-layout-benchmark [particles_count...]
+// By default runs with 10k, 1M and 10M particles.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "scene.hpp"
+#include "simulation/ColliderBVH.hpp"
+#include "simulation/ParticleSystem.hpp"
+#include "simulation/collision.hpp"
+#include "simulation/update.hpp"
+
+namespace {
+
+using bench::dt;
+
+/// Runs `step` `steps_count` times and returns the average time per particle, in nanoseconds
+template<typename Fn>
+auto time_per_particle(size_t particles_count, size_t steps_count, Fn&& step) -> double
+{
+    step(); // Warm-up
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps_count; ++i)
+        step();
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>{end - start}.count() / static_cast<double>(particles_count * steps_count);
+}
+
+void integrate(std::vector<sim::Particle>& particles)
+{
+    for (auto& p : particles)
+    {
+        p.age += dt;
+        p.position += p.velocity * dt;
+    }
+}
+
+void integrate(sim::ParticleSystem& particles)
+{
+    auto const   c = particles.columns();
+    size_t const n = particles.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        c.age[i] += dt;
+        c.position_x[i] += c.velocity_x[i] * dt;
+        c.position_y[i] += c.velocity_y[i] * dt;
+    }
+}
+
+void integrate_and_collide(std::vector<sim::Particle>& particles, sim::ColliderBVH const& colliders)
+{
+    for (auto& p : particles)
+    {
+        p.age += dt;
+        sim::step_particle(p.position, p.velocity, dt, colliders);
+    }
+}
+
+void print_result(char const* pass, size_t particles_count, double aos_ns, double soa_ns)
+{
+    std::printf("%-22s %10zu %12.2f %12.2f %9.2fx\n", pass, particles_count, aos_ns, soa_ns, aos_ns / soa_ns);
+}
+
+void run(size_t particles_count, sim::ColliderBVH const& colliders)
+{
+    // Keep the total amount of work roughly constant across sizes
+    size_t const steps_count = std::max<size_t>(3, 20'000'000 / particles_count);
+
+    auto aos = std::vector<sim::Particle>{};
+    aos.reserve(particles_count);
+    for (size_t i = 0; i < particles_count; ++i)
+        aos.push_back(sim::random_particle(bench::aspect_ratio));
+
+    auto soa = sim::ParticleSystem{particles_count};
+    for (auto const& p : aos)
+        soa.spawn(p);
+
+    {
+        double const aos_ns = time_per_particle(particles_count, steps_count, [&]() { integrate(aos); });
+        double const soa_ns = time_per_particle(particles_count, steps_count, [&]() { integrate(soa); });
+        print_result("integrate", particles_count, aos_ns, soa_ns);
+    }
+    {
+        double const aos_ns = time_per_particle(particles_count, steps_count, [&]() { integrate_and_collide(aos, colliders); });
+        double const soa_ns = time_per_particle(particles_count, steps_count, [&]() { sim::update_particles(soa, colliders, dt); });
+        print_result("integrate + collide", particles_count, aos_ns, soa_ns);
+    }
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto counts = std::vector<size_t>{};
+    for (int i = 1; i < argc; ++i)
+        counts.push_back(std::stoull(argv[i])); // NOLINT(*pointer-arithmetic)
+    if (counts.empty())
+        counts = {10'000, 1'000'000, 10'000'000};
+
+    auto const colliders = sim::ColliderBVH{bench::star_obstacles()};
+
+    std::printf("sizeof(sim::Particle) = %zu bytes\n\n", sizeof(sim::Particle));
+    std::printf("%-22s %10s %12s %12s %10s\n", "pass", "particles", "AoS ns/p", "SoA ns/p", "speedup");
+    for (size_t const count : counts)
+        run(count, colliders);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "simulation/scene.hpp"
+
+namespace bench {
+
+inline constexpr float dt           = 1.f / 60.f;
+inline constexpr float aspect_ratio = 16.f / 9.f;
+
+/// The same star, window borders and circles as in the app
+inline auto star_obstacles() -> sim::Obstacles
+{
+    return sim::star_obstacles(aspect_ratio);
+}
+
+} // namespace bench
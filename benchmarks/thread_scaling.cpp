@@ -0,0 +1,78 @@
+// Measures how the integrate + collide pass scales with the number of threads of the JobSystem.
+//
+// Usage: Particles-scaling-benchmark [particles_count] [max_threads] [--pin] [--gravity]
+// --gravity also measures the Barnes-Hut gravity pass.
+// By default uses 1M particles and goes up to one thread per hardware thread.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "scene.hpp"
+#include "simulation/BarnesHut.hpp"
+#include "simulation/ColliderBVH.hpp"
+#include "simulation/JobSystem.hpp"
+#include "simulation/ParticleSystem.hpp"
+#include "simulation/update.hpp"
+
+namespace {
+
+/// Returns the throughput of `step`, in particles·steps per second
+template<typename Fn>
+auto throughput(size_t particles_count, size_t steps_count, Fn&& step) -> double
+{
+    step(); // Warm-up
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps_count; ++i)
+        step();
+    auto const end = std::chrono::steady_clock::now();
+    return static_cast<double>(particles_count * steps_count) / std::chrono::duration<double>{end - start}.count();
+}
+
+auto threads_counts_to_test(size_t max_threads) -> std::vector<size_t>
+{
+    auto counts = std::vector<size_t>{};
+    for (size_t count = 1; count < max_threads; count *= 2)
+        counts.push_back(count);
+    counts.push_back(max_threads);
+    return counts;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto args = std::vector<std::string>{argv + 1, argv + argc}; // NOLINT(*pointer-arithmetic)
+    bool const pin_threads     = std::erase(args, "--pin") != 0;
+    bool const gravity_enabled = std::erase(args, "--gravity") != 0;
+
+    size_t const particles_count = args.size() > 0 ? std::stoull(args[0]) : 1'000'000;
+    size_t const max_threads     = args.size() > 1 ? std::stoull(args[1]) : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t const steps_count     = std::max<size_t>(3, (gravity_enabled ? 2'000'000 : 20'000'000) / particles_count);
+
+    auto const colliders = sim::ColliderBVH{bench::star_obstacles()};
+    auto       particles = sim::ParticleSystem{particles_count};
+    for (size_t i = 0; i < particles_count; ++i)
+        particles.spawn(sim::random_particle(bench::aspect_ratio));
+
+    std::printf("%zu particles, %zu steps per measure, threads %s%s\n\n", particles_count, steps_count, pin_threads ? "pinned" : "not pinned", gravity_enabled ? ", with gravity" : "");
+    std::printf("%8s %18s %9s %11s\n", "threads", "M particles·step/s", "speedup", "efficiency");
+
+    double single_thread_throughput = 0.;
+    for (size_t const threads_count : threads_counts_to_test(max_threads))
+    {
+        auto         jobs   = sim::JobSystem{{.threads_count = threads_count, .pin_threads = pin_threads}};
+        auto         tree   = sim::BarnesHutTree{};
+        double const result = throughput(particles_count, steps_count, [&]() {
+            if (gravity_enabled)
+                sim::apply_gravity(particles, tree, {}, bench::dt, jobs);
+            sim::update_particles(particles, colliders, bench::dt, jobs);
+        });
+        if (threads_count == 1)
+            single_thread_throughput = result;
+        double const speedup = result / single_thread_throughput;
+        std::printf("%8zu %18.2f %8.2fx %10.0f%%\n", threads_count, result / 1e6, speedup, 100. * speedup / static_cast<double>(threads_count));
+    }
+}
@@ -0,0 +1,139 @@
+// Runs the simulation of the app without a window nor an OpenGL context, and reports its throughput.
+// Meant for machines without a display, e.g. to catch performance regressions on build boxes.
+//
+// Usage: Particles-headless [--particles N] [--threads N] [--seed N] [--steps N] [--gravity]
+// By default simulates 1M particles for 100 steps, with one thread per hardware thread and a random seed.
+// The same seed and particle count always give the same final state, whatever the number of threads: its checksum is printed to compare runs.
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string_view>
+#include "simulation/BarnesHut.hpp"
+#include "simulation/ColliderBVH.hpp"
+#include "simulation/Emitter.hpp"
+#include "simulation/JobSystem.hpp"
+#include "simulation/ParticleSystem.hpp"
+#include "simulation/random.hpp"
+#include "simulation/scene.hpp"
+#include "simulation/update.hpp"
+
+namespace {
+
+constexpr float dt           = 1.f / 120.f; // Same fixed step as the app
+constexpr float aspect_ratio = 16.f / 9.f;
+
+struct Options {
+    size_t   particles_count{1'000'000};
+    size_t   threads_count{0}; // 0 means one per hardware thread
+    uint32_t seed{std::random_device{}()};
+    size_t   steps_count{100};
+    bool     gravity_enabled{false};
+};
+
+[[noreturn]] void exit_with_usage(char const* program_name)
+{
+    std::fprintf(stderr, "Usage: %s [--particles N] [--threads N] [--seed N] [--steps N] [--gravity]\n", program_name);
+    std::exit(EXIT_FAILURE);
+}
+
+auto parse_options(int argc, char** argv) -> Options
+{
+    auto options = Options{};
+    for (int i = 1; i < argc; ++i)
+    {
+        auto const arg = std::string_view{argv[i]};
+        if (arg == "--gravity")
+        {
+            options.gravity_enabled = true;
+            continue;
+        }
+        if (i + 1 == argc)
+            exit_with_usage(argv[0]);
+        char const* const text = argv[++i];
+        // strtoull() would skip leading spaces and wrap negative numbers around, so the value must start with a digit
+        if (!std::isdigit(static_cast<unsigned char>(text[0])))
+            exit_with_usage(argv[0]);
+        errno                          = 0;
+        char*                    end   = nullptr;
+        unsigned long long const value = std::strtoull(text, &end, 10);
+        if (*end != '\0' || errno == ERANGE)
+            exit_with_usage(argv[0]);
+
+        if (arg == "--particles")
+            options.particles_count = value;
+        else if (arg == "--threads")
+            options.threads_count = value;
+        else if (arg == "--seed")
+        {
+            if (value > std::numeric_limits<uint32_t>::max())
+                exit_with_usage(argv[0]);
+            options.seed = static_cast<uint32_t>(value);
+        }
+        else if (arg == "--steps")
+            options.steps_count = value;
+        else
+            exit_with_usage(argv[0]);
+    }
+    return options;
+}
+
+/// Order-independent summary of the state of the particles, to check that two runs ended up in the same state
+auto checksum(sim::ParticleSystem const& particles) -> double
+{
+    double sum = 0.;
+    for (size_t i = 0; i < particles.size(); ++i)
+        sum += static_cast<double>(particles.position_x()[i]) + 2. * static_cast<double>(particles.position_y()[i]);
+    return sum;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const options = parse_options(argc, argv);
+
+    // All the random numbers are drawn on this thread (the workers only integrate and collide), so this makes the whole run reproducible
+    sim::seed_random(options.seed);
+
+    auto const colliders = sim::ColliderBVH{sim::star_obstacles(aspect_ratio)};
+    auto       jobs      = sim::JobSystem{{.threads_count = options.threads_count}};
+    auto       particles = sim::ParticleSystem{options.particles_count};
+    auto       emitter   = sim::Emitter{{
+                .shape        = sim::EmitterShape::Rectangle{.half_size = {aspect_ratio, 1.f}},
+                .spawn_rate   = static_cast<float>(options.particles_count) / 7.5f,
+                .min_lifetime = 5.f,
+                .max_lifetime = 10.f,
+    }};
+    emitter.burst(particles, options.particles_count);
+
+    auto                          tree = sim::BarnesHutTree{};
+    sim::Gravity_Descriptor const gravity{
+        .gravitational_constant = 0.01f / static_cast<float>(std::max<size_t>(options.particles_count, 1)),
+    };
+
+    std::printf("%zu particles, %zu steps, %zu threads, seed %u%s\n", options.particles_count, options.steps_count, jobs.threads_count(), options.seed, options.gravity_enabled ? ", with gravity" : "");
+
+    size_t     simulated_particles = 0; // Sum over all the steps of the number of particles alive during the step
+    auto const start               = std::chrono::steady_clock::now();
+    for (size_t step = 0; step < options.steps_count; ++step)
+    {
+        simulated_particles += particles.size();
+        if (options.gravity_enabled)
+            sim::apply_gravity(particles, tree, gravity, dt, jobs);
+        sim::update_particles(particles, colliders, dt, jobs);
+        particles.kill_expired();
+        emitter.update(particles, dt);
+    }
+    auto const   end     = std::chrono::steady_clock::now();
+    double const seconds = std::chrono::duration<double>{end - start}.count();
+
+    std::printf("%.3f s, %.2f M particles·steps/s\n", seconds, static_cast<double>(simulated_particles) / seconds / 1e6);
+    std::printf("checksum %.6f\n", checksum(particles));
+}
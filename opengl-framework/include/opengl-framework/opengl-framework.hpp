@@ -5,8 +5,13 @@
 #include "../../src/Mesh.hpp"
 #include "../../src/RenderTarget.hpp"
 #include "../../src/Shader.hpp"
+#include "../../src/StorageBuffer.hpp"
+#include "../../src/StreamingBuffer.hpp"
 #include "../../src/Texture.hpp"
+#include "../../src/UniformBuffer.hpp"
+#include "../../src/extensions.hpp"
 #include "../../src/make_absolute_path.hpp"
+#include "../../src/shader_cache.hpp"
 #include "glad/gl.h"
 #include "glm/glm.hpp"
 #include "tiny_obj_loader.h"
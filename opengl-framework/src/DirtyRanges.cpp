@@ -0,0 +1,34 @@
+#include "DirtyRanges.hpp"
+#include <algorithm>
+
+namespace gl {
+
+void DirtyRanges::add(size_t begin, size_t end)
+{
+    if (begin >= end)
+        return;
+
+    // The first range that overlaps or touches [begin, end), and all the following ones that do too, are merged with it
+    auto first = std::lower_bound(_ranges.begin(), _ranges.end(), begin, [](Range const& range, size_t begin) {
+        return range.end < begin;
+    });
+    auto last = first;
+    while (last != _ranges.end() && last->begin <= end)
+    {
+        begin = std::min(begin, last->begin);
+        end   = std::max(end, last->end);
+        ++last;
+    }
+    first = _ranges.erase(first, last);
+    _ranges.insert(first, Range{begin, end});
+}
+
+auto DirtyRanges::total_size() const -> size_t
+{
+    size_t size{0};
+    for (auto const& range : _ranges)
+        size += range.end - range.begin;
+    return size;
+}
+
+} // namespace gl
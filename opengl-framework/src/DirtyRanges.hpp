@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace gl {
+
+/// Remembers which parts of a buffer have been modified, so that only those get uploaded.
+/// Overlapping and adjacent ranges are merged as they are added, so there are never more ranges than necessary.
+class DirtyRanges {
+public:
+    struct Range {
+        size_t begin;
+        size_t end; /// Excluded
+    };
+
+    /// Marks [begin, end) as modified
+    void add(size_t begin, size_t end);
+    void clear() { _ranges.clear(); }
+
+    auto empty() const -> bool { return _ranges.empty(); }
+    /// Sorted, and disjoint
+    auto ranges() const -> std::vector<Range> const& { return _ranges; }
+    auto total_size() const -> size_t;
+
+private:
+    std::vector<Range> _ranges{};
+};
+
+} // namespace gl
@@ -1,7 +1,9 @@
 #include "Mesh.hpp"
+#include <algorithm>
 #include <cassert>
 #include <numeric>
 #include <opengl-framework/opengl-framework.hpp>
+#include "handle_error.hpp"
 
 namespace gl {
 
@@ -17,9 +19,38 @@ static auto type(AnyVertexAttribute const& attr)
 {
     return std::visit([](auto&& attr) { return attr.type(); }, attr);
 }
-static auto size_in_bytes(AnyVertexAttribute const& attr)
+static auto normalized(AnyVertexAttribute const& attr)
 {
-    return size(attr) * 4;
+    return std::visit([](auto&& attr) { return attr.normalized(); }, attr);
+}
+static auto size_in_bytes(AnyVertexAttribute const& attr) -> int
+{
+    switch (type(attr))
+    {
+    case GL_INT_2_10_10_10_REV:
+        return 4; // All the components are packed together
+    case GL_HALF_FLOAT:
+    case GL_SHORT:
+        return size(attr) * 2;
+    case GL_UNSIGNED_BYTE:
+        return size(attr);
+    default:
+        return size(attr) * 4;
+    }
+}
+
+static auto gl_usage(BufferUsage usage) -> GLenum
+{
+    switch (usage)
+    {
+    case BufferUsage::Static:
+        return GL_STATIC_DRAW;
+    case BufferUsage::Dynamic:
+        return GL_DYNAMIC_DRAW;
+    case BufferUsage::Stream:
+        return GL_STREAM_DRAW;
+    }
+    return GL_STATIC_DRAW;
 }
 
 Mesh::Mesh(Mesh_Descriptor desc)
@@ -34,33 +65,45 @@ Mesh::Mesh(Mesh_Descriptor desc)
 
     { // Vertex Array
         glGenVertexArrays(1, &_vertex_array);
-        glBindVertexArray(_vertex_array);
+        state::bind_vertex_array(_vertex_array);
     }
 
     { // Vertex Buffers
         _vertex_buffers.resize(desc.vertex_buffers.size());
         glGenBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
+        bool has_counted_triangles{false};
         for (size_t i = 0; i < _vertex_buffers.size(); ++i)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffers[i]);
-            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(desc.vertex_buffers[i].data.size() * sizeof(GLfloat)), desc.vertex_buffers[i].data.data(), GL_STATIC_DRAW);
+            auto const usage = desc.vertex_buffers[i].usage;
+            auto const data  = desc.vertex_buffers[i].data.bytes();
+            state::bind_buffer(GL_ARRAY_BUFFER, _vertex_buffers[i]);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), data.data(), gl_usage(usage));
+            _vertex_buffers_updates.push_back({
+                .usage         = usage,
+                .size_in_bytes = data.size(),
+                .data          = usage == BufferUsage::Static ? std::vector<std::byte>{} : std::vector<std::byte>(data.begin(), data.end()),
+            });
 
             int const stride = std::accumulate(desc.vertex_buffers[i].layout.begin(), desc.vertex_buffers[i].layout.end(), 0, [](int acc, AnyVertexAttribute const& attr) {
                 return acc + size_in_bytes(attr);
             });
-            if (desc.index_buffer.empty())
+            if (desc.index_buffer.empty() && desc.vertex_buffers[i].divisor == 0) // Per-instance buffers don't say anything about the number of vertices
             {
-                auto const triangles_count = desc.vertex_buffers[i].data.size() / (stride / sizeof(float)) / 3;
-                if (i == 0)
+                assert(data.size() % static_cast<size_t>(stride) == 0 && "The size of the data must be a multiple of the size of a vertex. Make sure that the layout matches the data.");
+                auto const triangles_count = data.size() / static_cast<size_t>(stride) / 3;
+                if (!has_counted_triangles)
                     _triangles_count = triangles_count;
                 else
                     assert(_triangles_count == triangles_count && "Some vertex buffers contain more vertices than others! Make sure that their data is correct, and that the layout matches the data.");
+                has_counted_triangles = true;
             }
             uint64_t pointer{0};
             for (auto const& attribute : desc.vertex_buffers[i].layout)
             {
                 glEnableVertexAttribArray(index(attribute));
-                glVertexAttribPointer(index(attribute), size(attribute), type(attribute), GL_FALSE, stride, reinterpret_cast<void*>(pointer)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+                glVertexAttribPointer(index(attribute), size(attribute), type(attribute), normalized(attribute), stride, reinterpret_cast<void*>(pointer)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+                if (desc.vertex_buffers[i].divisor != 0)
+                    glVertexAttribDivisor(static_cast<GLuint>(index(attribute)), desc.vertex_buffers[i].divisor);
                 pointer += size_in_bytes(attribute);
             }
         }
@@ -76,9 +119,75 @@ Mesh::Mesh(Mesh_Descriptor desc)
     }
 }
 
+void Mesh::update_vertex_buffer(size_t vertex_buffer_index, VertexData data, size_t offset_in_bytes)
+{
+    assert(vertex_buffer_index < _vertex_buffers.size() && "This Mesh doesn't have that many vertex buffers");
+    auto const bytes   = data.bytes();
+    auto&      updates = _vertex_buffers_updates[vertex_buffer_index];
+    assert(offset_in_bytes + bytes.size() <= updates.size_in_bytes && "Writing past the end of the vertex buffer. Its size can't change.");
+    if (updates.usage == BufferUsage::Static)
+    {
+        state::bind_buffer(GL_ARRAY_BUFFER, _vertex_buffers[vertex_buffer_index]);
+        glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(bytes.size()), bytes.data());
+        return;
+    }
+    std::copy(bytes.begin(), bytes.end(), updates.data.begin() + static_cast<std::ptrdiff_t>(offset_in_bytes));
+    updates.dirty_ranges.add(offset_in_bytes, offset_in_bytes + bytes.size());
+}
+
+void Mesh::upload_updates() const
+{
+    for (size_t i = 0; i < _vertex_buffers.size(); ++i)
+    {
+        auto& updates = _vertex_buffers_updates[i];
+        if (updates.dirty_ranges.empty())
+            continue;
+
+        state::bind_buffer(GL_ARRAY_BUFFER, _vertex_buffers[i]);
+        if (updates.usage == BufferUsage::Stream || updates.dirty_ranges.total_size() == updates.data.size())
+        {
+            // New storage, so that we don't have to wait until the GPU is done reading the old one
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(updates.data.size()), updates.data.data(), gl_usage(updates.usage));
+        }
+        else
+        {
+            for (auto const& range : updates.dirty_ranges.ranges())
+                glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(range.begin), static_cast<GLsizeiptr>(range.end - range.begin), updates.data.data() + range.begin);
+        }
+        updates.dirty_ranges.clear();
+    }
+}
+
+void Mesh::draw_instanced(GLsizei instances_count, GLuint base_instance) const
+{
+    if (base_instance != 0 && !ext::has_version(4, 2))
+    {
+        handle_error("[Mesh] A non-zero base_instance requires OpenGL 4.2, which is not available on this machine");
+        return;
+    }
+    upload_updates();
+    state::bind_vertex_array(_vertex_array);
+    auto const vertices_count = static_cast<GLsizei>(3 * _triangles_count);
+    if (_maybe_index_buffer != 0)
+    {
+        if (base_instance == 0)
+            glDrawElementsInstanced(GL_TRIANGLES, vertices_count, GL_UNSIGNED_INT, reinterpret_cast<void*>(0), instances_count); // NOLINT(*reinterpret-cast)
+        else
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, vertices_count, GL_UNSIGNED_INT, reinterpret_cast<void*>(0), instances_count, base_instance); // NOLINT(*reinterpret-cast)
+    }
+    else
+    {
+        if (base_instance == 0)
+            glDrawArraysInstanced(GL_TRIANGLES, 0, vertices_count, instances_count);
+        else
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, vertices_count, instances_count, base_instance);
+    }
+}
+
 void Mesh::draw() const
 {
-    glBindVertexArray(_vertex_array);
+    upload_updates();
+    state::bind_vertex_array(_vertex_array);
     if (_maybe_index_buffer != 0)
         glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * _triangles_count), GL_UNSIGNED_INT, reinterpret_cast<void*>(0)); // NOLINT(*reinterpret-cast)
     else
@@ -87,20 +196,22 @@ void Mesh::draw() const
 
 Mesh::~Mesh()
 {
-    glDeleteVertexArrays(1, &_vertex_array);
+    state::delete_vertex_arrays({&_vertex_array, 1});
     if (!_vertex_buffers.empty()) // Might have been moved-from
-        glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
-    glDeleteBuffers(1, &_maybe_index_buffer);
+        state::delete_buffers(_vertex_buffers);
+    state::delete_buffers({&_maybe_index_buffer, 1});
 }
 
 Mesh::Mesh(Mesh&& o) noexcept
     : _vertex_array{o._vertex_array}
     , _vertex_buffers{std::move(o._vertex_buffers)}
+    , _vertex_buffers_updates{std::move(o._vertex_buffers_updates)}
     , _maybe_index_buffer{o._maybe_index_buffer}
     , _triangles_count{o._triangles_count}
 {
     o._vertex_array = 0;
     o._vertex_buffers.resize(0);
+    o._vertex_buffers_updates.resize(0);
     o._maybe_index_buffer = 0;
 }
 
@@ -109,19 +220,21 @@ auto Mesh::operator=(Mesh&& o) noexcept -> Mesh&
     if (this != &o)
     {
         // Delete this
-        glDeleteVertexArrays(1, &_vertex_array);
+        state::delete_vertex_arrays({&_vertex_array, 1});
         if (!_vertex_buffers.empty()) // Might have been moved-from
-            glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
-        glDeleteBuffers(1, &_maybe_index_buffer);
+            state::delete_buffers(_vertex_buffers);
+        state::delete_buffers({&_maybe_index_buffer, 1});
 
         // Move
-        _vertex_array       = o._vertex_array;
-        _vertex_buffers     = std::move(o._vertex_buffers);
-        _maybe_index_buffer = o._maybe_index_buffer;
-        _triangles_count    = o._triangles_count;
+        _vertex_array           = o._vertex_array;
+        _vertex_buffers         = std::move(o._vertex_buffers);
+        _vertex_buffers_updates = std::move(o._vertex_buffers_updates);
+        _maybe_index_buffer     = o._maybe_index_buffer;
+        _triangles_count        = o._triangles_count;
 
         o._vertex_array = 0;
         o._vertex_buffers.resize(0);
+        o._vertex_buffers_updates.resize(0);
         o._maybe_index_buffer = 0;
     }
     return *this;
@@ -1,6 +1,12 @@
 #pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <ranges>
+#include <span>
+#include <type_traits>
 #include <variant>
 #include <vector>
+#include "DirtyRanges.hpp"
 #include "glad/gl.h"
 
 namespace gl {
@@ -13,6 +19,8 @@ public:
     {}
 
     auto index() const -> int { return _index; }
+    /// Whether integer components are mapped to [0, 1] (unsigned) or [-1, 1] (signed) when the shader reads them as floats
+    static auto normalized() -> GLboolean { return GL_FALSE; }
 
 private:
     int _index{};
@@ -69,12 +77,62 @@ public:
     static auto type() -> GLenum { return GL_INT; }
 };
 
-using Position2D = Vec2;
-using Position3D = Vec3;
-using Normal3D   = Vec3;
-using UV         = Vec2;
-using ColorRGB   = Vec3;
-using ColorRGBA  = Vec4;
+// Compact formats, read as floats by the shaders. They take 2 to 4 times less memory and bandwidth than floats.
+// Their sizes are multiples of 4 bytes, so that the following attributes stay aligned. glm/gtc/packing.hpp can convert your data to them.
+class HalfVec2 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static auto size() -> GLint { return 2; }
+    static auto type() -> GLenum { return GL_HALF_FLOAT; }
+};
+class HalfVec4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static auto size() -> GLint { return 4; }
+    static auto type() -> GLenum { return GL_HALF_FLOAT; }
+};
+/// 4 unsigned bytes, read as floats in [0, 1]
+class UNorm8Vec4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static auto size() -> GLint { return 4; }
+    static auto type() -> GLenum { return GL_UNSIGNED_BYTE; }
+    static auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// 2 shorts, read as floats in [-1, 1]
+class SNorm16Vec2 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static auto size() -> GLint { return 2; }
+    static auto type() -> GLenum { return GL_SHORT; }
+    static auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// 4 shorts, read as floats in [-1, 1]
+class SNorm16Vec4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static auto size() -> GLint { return 4; }
+    static auto type() -> GLenum { return GL_SHORT; }
+    static auto normalized() -> GLboolean { return GL_TRUE; }
+};
+/// x, y and z on 10 bits and w on 2 bits, packed in 4 bytes (see glm::packSnorm3x10_1x2()), read as floats in [-1, 1]
+class SNormPacked_2_10_10_10 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static auto size() -> GLint { return 4; }
+    static auto type() -> GLenum { return GL_INT_2_10_10_10_REV; }
+    static auto normalized() -> GLboolean { return GL_TRUE; }
+};
+
+using Position2D     = Vec2;
+using Position3D     = Vec3;
+using Normal3D       = Vec3;
+using Normal3DPacked = SNormPacked_2_10_10_10;
+using UV             = Vec2;
+using UVHalf         = HalfVec2;
+using ColorRGB       = Vec3;
+using ColorRGBA      = Vec4;
+using ColorRGBA8     = UNorm8Vec4;
 } // namespace VertexAttribute
 
 using AnyVertexAttribute = std::variant<
@@ -85,11 +143,50 @@ using AnyVertexAttribute = std::variant<
     VertexAttribute::Int,
     VertexAttribute::IVec2,
     VertexAttribute::IVec3,
-    VertexAttribute::IVec4>;
+    VertexAttribute::IVec4,
+    VertexAttribute::HalfVec2,
+    VertexAttribute::HalfVec4,
+    VertexAttribute::UNorm8Vec4,
+    VertexAttribute::SNorm16Vec2,
+    VertexAttribute::SNorm16Vec4,
+    VertexAttribute::SNormPacked_2_10_10_10>;
+
+/// The bytes of a vertex buffer, described by its layout. Can be made from any contiguous container (e.g. a std::vector of floats, or of your own vertex struct), or from a braced list of floats.
+/// This is only a view: it doesn't copy the data, which must outlive the Mesh constructor or Mesh::update_vertex_buffer() call that reads it.
+/// So don't store a descriptor made from a braced list or a temporary vector in a variable: the data is destroyed at the end of the line. Pass it straight to the call, or keep the data in a variable.
+class VertexData {
+public:
+    VertexData(std::initializer_list<float> floats) // NOLINT(*explicit*)
+        : _bytes{std::as_bytes(std::span{floats.begin(), floats.size()})}
+    {}
+    template<std::ranges::contiguous_range Range>
+        requires std::is_trivially_copyable_v<std::ranges::range_value_t<Range>>
+    VertexData(Range const& data) // NOLINT(*explicit*)
+        : _bytes{std::as_bytes(std::span{std::ranges::data(data), std::ranges::size(data)})}
+    {}
+
+    auto bytes() const -> std::span<std::byte const> { return _bytes; }
+
+private:
+    std::span<std::byte const> _bytes;
+};
+
+/// Tells the driver how often you will update a vertex buffer with Mesh::update_vertex_buffer(), so that it can store it accordingly
+enum class BufferUsage {
+    /// Never, or very rarely, updated. Updates are uploaded immediately.
+    Static,
+    /// Partially updated from time to time. Updates are kept on the CPU and only the modified ranges are uploaded, by the next draw().
+    Dynamic,
+    /// Entirely rewritten about every frame. Updates are kept on the CPU, and the next draw() replaces the whole buffer with fresh storage (orphaning), so that it never waits for the GPU to be done with the previous data.
+    Stream,
+};
 
 struct VertexBuffer_Descriptor {
     std::vector<AnyVertexAttribute> const& layout; // NOLINT(*avoid-const-or-ref-data-members)
-    std::vector<float> const&              data;   // NOLINT(*avoid-const-or-ref-data-members)
+    VertexData                             data;
+    BufferUsage                            usage{BufferUsage::Static};
+    /// 0 for per-vertex attributes. With draw_instanced(), 1 makes the attributes of this buffer advance once per instance instead, and N once every N instances.
+    GLuint                                 divisor{0};
 };
 
 struct Mesh_Descriptor {
@@ -106,12 +203,32 @@ public:
     Mesh(Mesh&&) noexcept;
     auto operator=(Mesh&&) noexcept -> Mesh&;
 
+    /// Replaces the vertex data of the `vertex_buffer_index`-th buffer of the Mesh_Descriptor, starting at `offset_in_bytes`.
+    /// The size of the buffer can't change: to draw more vertices, create a new Mesh.
+    void update_vertex_buffer(size_t vertex_buffer_index, VertexData data, size_t offset_in_bytes = 0);
+
+    /// Uploads the updates of the Dynamic and Stream vertex buffers first, if there are some
     void draw() const;
+    /// Draws the mesh `instances_count` times with a single draw call. The vertex buffers with a divisor provide the per-instance attributes, starting at instance `base_instance`.
+    /// A non-zero base_instance requires OpenGL 4.2, so it is not available on MacOS: the error goes through handle_error() and nothing is drawn.
+    void draw_instanced(GLsizei instances_count, GLuint base_instance = 0) const;
+
+private:
+    /// The CPU copy of a Dynamic or Stream vertex buffer, and the parts of it that have been updated since the last upload
+    struct VertexBufferUpdates {
+        BufferUsage            usage;
+        size_t                 size_in_bytes;
+        std::vector<std::byte> data{}; /// Empty for Static buffers
+        DirtyRanges            dirty_ranges{};
+    };
+
+    void upload_updates() const;
 
 private:
-    GLuint              _vertex_array{};
-    std::vector<GLuint> _vertex_buffers{};
-    GLuint              _maybe_index_buffer{};
+    GLuint                                   _vertex_array{};
+    std::vector<GLuint>                      _vertex_buffers{};
+    mutable std::vector<VertexBufferUpdates> _vertex_buffers_updates{}; /// Parallel to _vertex_buffers. Mutable because draw() uploads them.
+    GLuint                                   _maybe_index_buffer{};
 
     size_t _triangles_count{};
 };
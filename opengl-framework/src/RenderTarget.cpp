@@ -1,5 +1,4 @@
 #include "RenderTarget.hpp"
-#include <array>
 #include "Texture.hpp"
 #include "handle_error.hpp"
 
@@ -95,29 +94,6 @@ RenderTarget::RenderTarget(RenderTarget_Descriptor const& desc)
     create_attachments(desc);
 }
 
-void RenderTarget::render(std::function<void()> const& render_fn)
-{
-    // Store previous state to restore it at the end
-    int                previous_draw_framebuffer{};
-    int                previous_read_framebuffer{};
-    std::array<int, 4> previous_viewport{};
-    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw_framebuffer);
-    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_framebuffer);
-    glGetIntegerv(GL_VIEWPORT, previous_viewport.data());
-
-    // Bind our framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, _id.id());
-    glViewport(0, 0, _desc.width, _desc.height);
-
-    // Render
-    render_fn();
-
-    // Re-bind previous framebuffer
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_draw_framebuffer);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous_read_framebuffer);
-    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
-}
-
 void RenderTarget::resize(int width, int height)
 {
     _desc.width  = width;
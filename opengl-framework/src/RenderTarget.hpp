@@ -1,7 +1,11 @@
 #pragma once
-#include <functional>
+#include <cassert>
+#include <optional>
+#include <utility>
+#include <vector>
 #include "Texture.hpp"
 #include "glad/gl.h"
+#include "state_cache.hpp"
 
 namespace gl {
 
@@ -14,7 +18,7 @@ public:
     }
     ~UniqueFramebuffer()
     {
-        glDeleteFramebuffers(1, &_id);
+        state::delete_framebuffers({&_id, 1});
     }
     UniqueFramebuffer(UniqueFramebuffer const&)                    = delete; // You cannot copy
     auto operator=(UniqueFramebuffer const&) -> UniqueFramebuffer& = delete; // a RenderTarget. But you can move it, using std::move(my_render_target)
@@ -27,7 +31,7 @@ public:
     {
         if (&o != this)
         {
-            glDeleteFramebuffers(1, &_id);
+            state::delete_framebuffers({&_id, 1});
             _id   = o._id;
             o._id = 0;
         }
@@ -62,7 +66,15 @@ class RenderTarget {
 public:
     explicit RenderTarget(RenderTarget_Descriptor const&);
 
-    void render(std::function<void()> const& render_fn);
+    /// Everything drawn by render_fn goes into this RenderTarget. The framebuffer and viewport bound before are restored afterwards.
+    /// Calls can be nested, and never query OpenGL (see state::push_framebuffer()).
+    template<typename RenderFn>
+    void render(RenderFn&& render_fn)
+    {
+        state::push_framebuffer(_id.id(), {0, 0, _desc.width, _desc.height});
+        std::forward<RenderFn>(render_fn)();
+        state::pop_framebuffer();
+    }
     void resize(GLsizei width, GLsizei height);
 
     auto color_texture(size_t index) const -> Texture const& { return _color_textures.at(index); }
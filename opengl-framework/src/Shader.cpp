@@ -1,32 +1,44 @@
 #include "Shader.hpp"
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include "Texture.hpp"
+#include "extensions.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "handle_error.hpp"
 #include "make_absolute_path.hpp"
+#include "shader_cache.hpp"
+#include "state_cache.hpp"
 
 namespace {
 
+/// Only starts the compilation: the driver might compile in the background until we ask for the result, see check_for_compilation_errors()
 void compile_shader_module(GLuint id, std::string const& source_code)
 {
     char const* src = source_code.c_str();
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
+}
 
-    { // Check for errors
-        int result;
-        glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-        if (result)
-            return; // Compilation successful
+void check_for_compilation_errors(GLuint id)
+{
+    int result;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
+    if (result)
+        return; // Compilation successful
 
-        GLsizei length;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        std::vector<GLchar> error_message;
-        error_message.resize(static_cast<size_t>(length));
-        glGetShaderInfoLog(id, length, nullptr, error_message.data());
-        gl::handle_error(std::format("Shader Compilation failed:\n{}\n\nThe code we tried to compile was:\n{}", error_message.data(), source_code));
-    }
+    GLsizei length;
+    glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> error_message;
+    error_message.resize(static_cast<size_t>(length));
+    glGetShaderInfoLog(id, length, nullptr, error_message.data());
+
+    GLsizei source_length;
+    glGetShaderiv(id, GL_SHADER_SOURCE_LENGTH, &source_length);
+    std::vector<GLchar> source_code;
+    source_code.resize(static_cast<size_t>(source_length));
+    glGetShaderSource(id, source_length, nullptr, source_code.data());
+    gl::handle_error(std::format("Shader Compilation failed:\n{}\n\nThe code we tried to compile was:\n{}", error_message.data(), source_code.data()));
 }
 
 auto get_source_code(gl::ShaderSource::Code const& source) -> std::string
@@ -38,13 +50,17 @@ auto get_source_code(gl::ShaderSource::File const& source) -> std::string
     auto ifs = std::ifstream{gl::make_absolute_path(source.path)};
     return std::string{std::istreambuf_iterator<char>{ifs}, {}};
 }
+auto get_source_code(gl::AnyShaderSource const& source) -> std::string
+{
+    return std::visit([](auto&& source) { return get_source_code(source); }, source);
+}
 
 class UniqueShaderModule {
 public:
-    explicit UniqueShaderModule(GLenum shader_kind, gl::AnyShaderSource const& source)
+    explicit UniqueShaderModule(GLenum shader_kind, std::string const& source_code)
         : _id{glCreateShader(shader_kind)}
     {
-        compile_shader_module(_id, std::visit([](auto&& source) { return get_source_code(source); }, source));
+        compile_shader_module(_id, source_code);
     }
     ~UniqueShaderModule()
     {
@@ -74,6 +90,13 @@ private:
     GLuint _id;
 };
 
+/// The module is deleted as soon as the program doesn't need it anymore, i.e. once it is linked and the module is detached
+void attach_shader_module(GLuint program_id, GLenum shader_kind, std::string const& source_code)
+{
+    auto const shader_module = UniqueShaderModule{shader_kind, source_code};
+    glAttachShader(program_id, shader_module.id());
+}
+
 void check_for_linking_errors(GLuint shader_id)
 {
     int result;
@@ -89,20 +112,143 @@ void check_for_linking_errors(GLuint shader_id)
     }
 }
 
+void set_uniform_block_binding(GLuint shader_id, std::string const& block_name, GLuint binding)
+{
+    GLuint const index = glGetUniformBlockIndex(shader_id, block_name.c_str());
+    if (index == GL_INVALID_INDEX) // The block is not used by the shader, and has been optimized away. Just like setting a uniform that doesn't exist, this is not an error.
+        return;
+    glUniformBlockBinding(shader_id, index, binding);
+}
+
 } // namespace
 
 namespace gl {
 
 Shader::Shader(Shader_Descriptor const& desc)
 {
-    auto vertex_shader   = UniqueShaderModule{GL_VERTEX_SHADER, desc.vertex};
-    auto fragment_shader = UniqueShaderModule{GL_FRAGMENT_SHADER, desc.fragment};
-    glAttachShader(id(), vertex_shader.id());
-    glAttachShader(id(), fragment_shader.id());
+    auto const vertex_code   = get_source_code(desc.vertex);
+    auto const fragment_code = get_source_code(desc.fragment);
+    auto const cache_key     = internal::shader_cache_key({"vertex", vertex_code, "fragment", fragment_code});
+    if (internal::load_from_shader_cache(id(), cache_key))
+    {
+        load_uniform_locations();
+        return;
+    }
+
+    attach_shader_module(id(), GL_VERTEX_SHADER, vertex_code);
+    attach_shader_module(id(), GL_FRAGMENT_SHADER, fragment_code);
+    link(cache_key);
+    if (!desc.compile_asynchronously)
+        finish_linking();
+}
+
+void Shader::link(std::string cache_key)
+{
+    internal::prepare_for_shader_cache(id());
     glLinkProgram(id());
-    glDetachShader(id(), fragment_shader.id());
-    glDetachShader(id(), vertex_shader.id());
+    _pending_link_cache_key = std::move(cache_key);
+}
+
+void Shader::finish_linking() const
+{
+    if (!_pending_link_cache_key)
+        return;
+    auto const cache_key = std::move(*_pending_link_cache_key);
+    _pending_link_cache_key.reset();
+
+    GLint modules_count{};
+    glGetProgramiv(id(), GL_ATTACHED_SHADERS, &modules_count);
+    auto modules = std::vector<GLuint>(static_cast<size_t>(modules_count));
+    glGetAttachedShaders(id(), modules_count, nullptr, modules.data());
+    for (GLuint const shader_module : modules)
+        check_for_compilation_errors(shader_module);
     check_for_linking_errors(id());
+    for (GLuint const shader_module : modules)
+        glDetachShader(id(), shader_module);
+
+    internal::save_to_shader_cache(id(), cache_key);
+    load_uniform_locations();
+    for (auto const& block : _pending_uniform_block_bindings)
+        set_uniform_block_binding(id(), block.name, block.binding);
+    _pending_uniform_block_bindings.clear();
+}
+
+auto Shader::is_ready() const -> bool
+{
+    if (!_pending_link_cache_key || !ext::has_parallel_shader_compile())
+        return true;
+    GLint is_complete{};
+    glGetProgramiv(id(), ext::COMPLETION_STATUS, &is_complete);
+    return is_complete == GL_TRUE;
+}
+
+ComputeShader::ComputeShader(ComputeShader_Descriptor const& desc)
+{
+    if (!ext::has_version(4, 3))
+        handle_error("[ComputeShader] Compute shaders require OpenGL 4.3, which is not available on this machine");
+
+    auto const compute_code = get_source_code(desc.compute);
+    auto const cache_key    = internal::shader_cache_key({"compute", compute_code});
+    if (internal::load_from_shader_cache(id(), cache_key))
+    {
+        load_uniform_locations();
+    }
+    else
+    {
+        attach_shader_module(id(), GL_COMPUTE_SHADER, compute_code);
+        link(cache_key);
+        finish_linking();
+    }
+
+    GLint size[3]; // NOLINT(*avoid-c-arrays)
+    glGetProgramiv(id(), GL_COMPUTE_WORK_GROUP_SIZE, size);
+    _work_group_size = glm::uvec3{size[0], size[1], size[2]};
+}
+
+void ComputeShader::dispatch(glm::uvec3 const& groups_count) const
+{
+    bind();
+    glDispatchCompute(groups_count.x, groups_count.y, groups_count.z);
+}
+
+void ComputeShader::dispatch_for(GLuint invocations_count) const
+{
+    dispatch({(invocations_count + _work_group_size.x - 1) / _work_group_size.x, 1, 1});
+}
+
+TransformFeedbackShader::TransformFeedbackShader(TransformFeedbackShader_Descriptor const& desc)
+{
+    auto const vertex_code = get_source_code(desc.vertex);
+    auto       outputs     = std::string{};
+    for (auto const& output : desc.captured_outputs)
+        outputs += output + ' ';
+    auto const cache_key = internal::shader_cache_key({"transform feedback", vertex_code, outputs});
+    if (internal::load_from_shader_cache(id(), cache_key))
+    {
+        load_uniform_locations();
+        return;
+    }
+
+    attach_shader_module(id(), GL_VERTEX_SHADER, vertex_code);
+    // Must be known before linking, so that the linker lays the outputs out in the buffer
+    auto captured_outputs = std::vector<char const*>{};
+    for (auto const& output : desc.captured_outputs)
+        captured_outputs.push_back(output.c_str());
+    glTransformFeedbackVaryings(id(), static_cast<GLsizei>(captured_outputs.size()), captured_outputs.data(), GL_INTERLEAVED_ATTRIBS);
+    link(cache_key);
+    finish_linking();
+}
+
+void TransformFeedbackShader::run(GLsizei vertices_count, GLuint output_buffer) const
+{
+    bind();
+    glEnable(GL_RASTERIZER_DISCARD);
+    state::bind_buffer_base(GL_TRANSFORM_FEEDBACK_BUFFER, 0, output_buffer);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, vertices_count);
+    glEndTransformFeedback();
+    state::bind_buffer_base(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
 }
 
 static void assert_shader_is_bound(GLuint id)
@@ -118,87 +264,189 @@ static void assert_shader_is_bound(GLuint id)
 
 void Shader::bind() const
 {
-    glUseProgram(id());
+    finish_linking();
+    state::use_program(id());
 }
 
-auto Shader::uniform_location(std::string_view uniform_name) const -> GLint
+void Shader::load_uniform_locations() const
 {
-    auto const name = std::string{uniform_name};
-    auto const it   = _uniform_locations.find(name);
-    if (it != _uniform_locations.end())
-    {
-        return it->second;
-    }
-    else
+    GLint uniforms_count{};
+    glGetProgramiv(id(), GL_ACTIVE_UNIFORMS, &uniforms_count);
+    GLint max_name_length{};
+    glGetProgramiv(id(), GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+    auto name_buffer = std::vector<GLchar>(static_cast<size_t>(std::max(max_name_length, 1)));
+
+    _uniform_locations.clear();
+    for (GLuint i = 0; i < static_cast<GLuint>(uniforms_count); ++i)
     {
-        GLint const location     = glGetUniformLocation(id(), name.c_str());
-        _uniform_locations[name] = location;
-        return location;
+        GLsizei length{};
+        GLint   array_size{};
+        GLenum  type{};
+        glGetActiveUniform(id(), i, max_name_length, &length, &array_size, &type, name_buffer.data());
+        auto const name = std::string{name_buffer.data(), static_cast<size_t>(length)};
+
+        GLint const location = glGetUniformLocation(id(), name.c_str());
+        if (location == -1) // The members of uniform blocks don't have a location
+            continue;
+        _uniform_locations.push_back({name, location});
+
+        // Arrays are listed as "name[0]", but can also be set as "name", or element by element as "name[i]"
+        if (name.ends_with("[0]"))
+        {
+            auto const array_name = name.substr(0, name.size() - 3);
+            _uniform_locations.push_back({array_name, location});
+            for (GLint element = 1; element < array_size; ++element)
+            {
+                auto element_name = std::format("{}[{}]", array_name, element);
+                _uniform_locations.push_back({element_name, glGetUniformLocation(id(), element_name.c_str())});
+            }
+        }
     }
+    std::sort(_uniform_locations.begin(), _uniform_locations.end(), [](UniformLocation const& a, UniformLocation const& b) {
+        return a.name < b.name;
+    });
+}
+
+auto Shader::uniform_handle(std::string_view uniform_name) const -> UniformHandle
+{
+    finish_linking();
+    auto const it = std::lower_bound(_uniform_locations.begin(), _uniform_locations.end(), uniform_name, [](UniformLocation const& uniform, std::string_view name) {
+        return uniform.name < name;
+    });
+    if (it == _uniform_locations.end() || it->name != uniform_name)
+        return UniformHandle{-1}; // Just like glGetUniformLocation(), so that setting a uniform that doesn't exist (e.g. that has been optimized away) is not an error
+    return UniformHandle{it->location};
 }
 
 void Shader::set_uniform(std::string_view uniform_name, int v) const
 {
-    assert_shader_is_bound(id());
-    glUniform1i(uniform_location(uniform_name), v);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, unsigned int v) const
 {
-    set_uniform(uniform_name, static_cast<int>(v));
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, bool v) const
 {
-    set_uniform(uniform_name, v ? 1 : 0);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, float v) const
 {
-    assert_shader_is_bound(id());
-    glUniform1f(uniform_location(uniform_name), v);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::vec2& v) const
 {
-    assert_shader_is_bound(id());
-    glUniform2f(uniform_location(uniform_name), v.x, v.y);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::vec3& v) const
 {
-    assert_shader_is_bound(id());
-    glUniform3f(uniform_location(uniform_name), v.x, v.y, v.z);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::vec4& v) const
 {
-    assert_shader_is_bound(id());
-    glUniform4f(uniform_location(uniform_name), v.x, v.y, v.z, v.w);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::uvec2& v) const
 {
-    assert_shader_is_bound(id());
-    glUniform2ui(uniform_location(uniform_name), v.x, v.y);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::uvec3& v) const
 {
-    assert_shader_is_bound(id());
-    glUniform3ui(uniform_location(uniform_name), v.x, v.y, v.z);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::uvec4& v) const
 {
-    assert_shader_is_bound(id());
-    glUniform4ui(uniform_location(uniform_name), v.x, v.y, v.z, v.w);
+    set_uniform(uniform_handle(uniform_name), v);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::mat2& mat) const
 {
-    assert_shader_is_bound(id());
-    glUniformMatrix2fv(uniform_location(uniform_name), 1, GL_FALSE, glm::value_ptr(mat));
+    set_uniform(uniform_handle(uniform_name), mat);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::mat3& mat) const
 {
-    assert_shader_is_bound(id());
-    glUniformMatrix3fv(uniform_location(uniform_name), 1, GL_FALSE, glm::value_ptr(mat));
+    set_uniform(uniform_handle(uniform_name), mat);
 }
 void Shader::set_uniform(std::string_view uniform_name, const glm::mat4& mat) const
+{
+    set_uniform(uniform_handle(uniform_name), mat);
+}
+void Shader::set_uniform(std::string_view uniform_name, Texture const& texture) const
+{
+    set_uniform(uniform_handle(uniform_name), texture);
+}
+
+void Shader::set_uniform(UniformHandle uniform, int v) const
+{
+    assert_shader_is_bound(id());
+    glUniform1i(uniform.location(), v);
+}
+void Shader::set_uniform(UniformHandle uniform, unsigned int v) const
+{
+    set_uniform(uniform, static_cast<int>(v));
+}
+void Shader::set_uniform(UniformHandle uniform, bool v) const
+{
+    set_uniform(uniform, v ? 1 : 0);
+}
+void Shader::set_uniform(UniformHandle uniform, float v) const
+{
+    assert_shader_is_bound(id());
+    glUniform1f(uniform.location(), v);
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::vec2& v) const
 {
     assert_shader_is_bound(id());
-    glUniformMatrix4fv(uniform_location(uniform_name), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniform2f(uniform.location(), v.x, v.y);
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::vec3& v) const
+{
+    assert_shader_is_bound(id());
+    glUniform3f(uniform.location(), v.x, v.y, v.z);
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::vec4& v) const
+{
+    assert_shader_is_bound(id());
+    glUniform4f(uniform.location(), v.x, v.y, v.z, v.w);
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::uvec2& v) const
+{
+    assert_shader_is_bound(id());
+    glUniform2ui(uniform.location(), v.x, v.y);
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::uvec3& v) const
+{
+    assert_shader_is_bound(id());
+    glUniform3ui(uniform.location(), v.x, v.y, v.z);
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::uvec4& v) const
+{
+    assert_shader_is_bound(id());
+    glUniform4ui(uniform.location(), v.x, v.y, v.z, v.w);
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::mat2& mat) const
+{
+    assert_shader_is_bound(id());
+    glUniformMatrix2fv(uniform.location(), 1, GL_FALSE, glm::value_ptr(mat));
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::mat3& mat) const
+{
+    assert_shader_is_bound(id());
+    glUniformMatrix3fv(uniform.location(), 1, GL_FALSE, glm::value_ptr(mat));
+}
+void Shader::set_uniform(UniformHandle uniform, const glm::mat4& mat) const
+{
+    assert_shader_is_bound(id());
+    glUniformMatrix4fv(uniform.location(), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::bind_uniform_block(std::string_view block_name, GLuint binding) const
+{
+    if (_pending_link_cache_key) // Looking the block up now would wait for the linking to finish
+    {
+        _pending_uniform_block_bindings.push_back({std::string{block_name}, binding});
+        return;
+    }
+    set_uniform_block_binding(id(), std::string{block_name}, binding);
 }
 
 static auto max_number_of_texture_slots() -> GLuint
@@ -219,13 +467,11 @@ static auto get_next_texture_slot() -> GLuint
     return current_slot;
 }
 
-void Shader::set_uniform(std::string_view uniform_name, Texture const& texture) const
+void Shader::set_uniform(UniformHandle uniform, Texture const& texture) const
 {
     auto const slot = get_next_texture_slot();
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, texture.id());
-    set_uniform(uniform_name, slot);
-    glActiveTexture(GL_TEXTURE0); // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
+    state::bind_texture(slot, GL_TEXTURE_2D, texture.id());
+    set_uniform(uniform, slot);
 }
 
 // void Shader::set_uniform_texture(std::string_view uniform_name, GLuint texture_id, TextureSamplerDescriptor const& sampler) const
@@ -1,9 +1,10 @@
 #pragma once
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <variant>
+#include <vector>
 #include "Texture.hpp"
 #include "glad/gl.h"
 #include "glm/glm.hpp"
@@ -58,16 +59,38 @@ using AnyShaderSource = std::variant<
     ShaderSource::File,
     ShaderSource::Code>;
 
+/// Identifies a uniform of a Shader, see Shader::uniform_handle()
+class UniformHandle {
+public:
+    auto location() const -> GLint { return _location; }
+
+private:
+    friend class Shader;
+    explicit UniformHandle(GLint location)
+        : _location{location}
+    {}
+
+    GLint _location;
+};
+
 struct Shader_Descriptor {
     AnyShaderSource vertex{};
     AnyShaderSource fragment{};
+    /// If true, the constructor returns as soon as the compilation has started, and the driver compiles in the background (if it supports it, see gl::ext::has_parallel_shader_compile()).
+    /// Compilation errors are then only reported by the first bind(), which waits for the compilation to finish.
+    /// Create all your shaders first, then load your other assets, and both will happen at the same time.
+    bool compile_asynchronously{false};
 };
 
 class Shader {
 public:
     explicit Shader(Shader_Descriptor const&);
 
+    /// Doesn't wait for an asynchronous compilation to finish, unlike the other functions
     auto id() const -> GLuint { return _id.id(); }
+    /// False while the shader is being compiled asynchronously, in which case bind() would wait for it.
+    /// Always true when the driver doesn't support GL_KHR_parallel_shader_compile, since there is no way to know, even though the driver might still be compiling in the background.
+    auto is_ready() const -> bool;
 
     void bind() const;
     void set_uniform(std::string_view uniform_name, int) const;
@@ -85,12 +108,89 @@ public:
     void set_uniform(std::string_view uniform_name, glm::mat4 const&) const;
     void set_uniform(std::string_view uniform_name, Texture const&) const;
 
+    /// Looks the uniform up once, so that setting it through the handle is as cheap as it gets. The handle sets nothing if the shader has no such uniform.
+    auto uniform_handle(std::string_view uniform_name) const -> UniformHandle;
+    void set_uniform(UniformHandle, int) const;
+    void set_uniform(UniformHandle, unsigned int) const;
+    void set_uniform(UniformHandle, bool) const;
+    void set_uniform(UniformHandle, float) const;
+    void set_uniform(UniformHandle, glm::vec2 const&) const;
+    void set_uniform(UniformHandle, glm::vec3 const&) const;
+    void set_uniform(UniformHandle, glm::vec4 const&) const;
+    void set_uniform(UniformHandle, glm::uvec2 const&) const;
+    void set_uniform(UniformHandle, glm::uvec3 const&) const;
+    void set_uniform(UniformHandle, glm::uvec4 const&) const;
+    void set_uniform(UniformHandle, glm::mat2 const&) const;
+    void set_uniform(UniformHandle, glm::mat3 const&) const;
+    void set_uniform(UniformHandle, glm::mat4 const&) const;
+    void set_uniform(UniformHandle, Texture const&) const;
+
+    /// The uniform block `block_name` will read the buffer bound to `binding`, e.g. with UniformBuffer::bind(binding). The program remembers it, so this only needs to be done once.
+    /// This is what `layout(binding = N)` does in GLSL 4.20, which MacOS doesn't have.
+    /// Doesn't wait for an asynchronous compilation to finish: the binding is applied once the program is linked.
+    void bind_uniform_block(std::string_view block_name, GLuint binding) const;
+
+protected:
+    /// For the derived classes that attach their own stages
+    Shader() = default;
+    /// Starts linking the stages that have been attached. The program will be saved under `cache_key` in the shader cache once linked.
+    void link(std::string cache_key);
+    /// Waits for the compilation and linking to finish, and reports their errors. Does nothing if they are already finished.
+    void finish_linking() const;
+    /// Must be called once the program is linked, so that uniforms can be found by name
+    void load_uniform_locations() const;
+
 private:
-    auto uniform_location(std::string_view uniform_name) const -> GLint;
+    struct UniformLocation {
+        std::string name;
+        GLint       location;
+    };
+    struct UniformBlockBinding {
+        std::string name;
+        GLuint      binding;
+    };
+
+    internal::UniqueShader                   _id{};
+    mutable std::vector<UniformLocation>     _uniform_locations{};              /// Sorted by name, so that a name can be looked up without allocating
+    mutable std::optional<std::string>       _pending_link_cache_key{};         /// Set until finish_linking() has checked the result of link()
+    mutable std::vector<UniformBlockBinding> _pending_uniform_block_bindings{}; /// The bind_uniform_block() calls made before the program was linked, applied by finish_linking()
+};
+
+struct ComputeShader_Descriptor {
+    AnyShaderSource compute{};
+};
+
+/// A program made of a single compute stage, that you can dispatch on work groups.
+/// Compute shaders require OpenGL 4.3, which MacOS doesn't have: check gl::ext::has_version(4, 3) before using them.
+class ComputeShader : public Shader {
+public:
+    explicit ComputeShader(ComputeShader_Descriptor const&);
+
+    /// The local_size declared in the shader
+    auto work_group_size() const -> glm::uvec3 { return _work_group_size; }
+
+    /// Binds the shader and runs it on `groups_count` work groups
+    void dispatch(glm::uvec3 const& groups_count) const;
+    /// Binds the shader and runs enough work groups along x to have at least `invocations_count` invocations. The shader must ignore the extra ones.
+    void dispatch_for(GLuint invocations_count) const;
 
 private:
-    internal::UniqueShader                         _id{};
-    mutable std::unordered_map<std::string, GLint> _uniform_locations{};
+    glm::uvec3 _work_group_size{};
+};
+
+struct TransformFeedbackShader_Descriptor {
+    AnyShaderSource          vertex{};
+    std::vector<std::string> captured_outputs{}; /// The outputs of the vertex shader that are written to the output buffer, interleaved in this order
+};
+
+/// A program made of a single vertex stage, whose outputs are written to a buffer instead of being rasterized (transform feedback).
+/// It lets the GPU update data in buffers even without compute shaders: it is core since OpenGL 4.0, so it is available on MacOS too.
+class TransformFeedbackShader : public Shader {
+public:
+    explicit TransformFeedbackShader(TransformFeedbackShader_Descriptor const&);
+
+    /// Binds the shader, runs it on the first `vertices_count` vertices of the bound vertex array, and writes its captured outputs to `output_buffer`. Nothing is drawn.
+    void run(GLsizei vertices_count, GLuint output_buffer) const;
 };
 
 } // namespace gl
\ No newline at end of file
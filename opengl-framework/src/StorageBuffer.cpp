@@ -0,0 +1,65 @@
+#include "StorageBuffer.hpp"
+#include <cassert>
+#include "extensions.hpp"
+#include "handle_error.hpp"
+#include "state_cache.hpp"
+
+namespace gl {
+
+StorageBuffer::StorageBuffer(StorageBuffer_Descriptor const& desc)
+    : _size_in_bytes{desc.size_in_bytes}
+{
+    if (!ext::has_version(4, 3))
+        handle_error("[StorageBuffer] Shader storage buffers require OpenGL 4.3, which is not available on this machine");
+    assert(desc.size_in_bytes > 0 && "A StorageBuffer can't be empty");
+
+    glGenBuffers(1, &_id);
+    state::bind_buffer(GL_SHADER_STORAGE_BUFFER, _id);
+    // Written and read by the GPU, only occasionally by the CPU
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(desc.size_in_bytes), desc.data, GL_DYNAMIC_COPY);
+}
+
+void StorageBuffer::bind(GLuint binding) const
+{
+    state::bind_buffer_base(GL_SHADER_STORAGE_BUFFER, binding, _id);
+}
+
+void StorageBuffer::upload(std::span<std::byte const> data, size_t offset_in_bytes)
+{
+    assert(offset_in_bytes + data.size() <= _size_in_bytes && "Writing past the end of the buffer");
+    state::bind_buffer(GL_SHADER_STORAGE_BUFFER, _id);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(data.size()), data.data());
+}
+
+void StorageBuffer::download(std::span<std::byte> data, size_t offset_in_bytes) const
+{
+    assert(offset_in_bytes + data.size() <= _size_in_bytes && "Reading past the end of the buffer");
+    state::bind_buffer(GL_SHADER_STORAGE_BUFFER, _id);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(data.size()), data.data());
+}
+
+StorageBuffer::~StorageBuffer()
+{
+    state::delete_buffers({&_id, 1});
+}
+
+StorageBuffer::StorageBuffer(StorageBuffer&& o) noexcept
+    : _id{o._id}
+    , _size_in_bytes{o._size_in_bytes}
+{
+    o._id = 0;
+}
+
+auto StorageBuffer::operator=(StorageBuffer&& o) noexcept -> StorageBuffer&
+{
+    if (this != &o)
+    {
+        state::delete_buffers({&_id, 1});
+        _id            = o._id;
+        _size_in_bytes = o._size_in_bytes;
+        o._id          = 0;
+    }
+    return *this;
+}
+
+} // namespace gl
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include "glad/gl.h"
+
+namespace gl {
+
+struct StorageBuffer_Descriptor {
+    size_t      size_in_bytes{};
+    void const* data{nullptr}; /// Initial content of the buffer. It is left uninitialized if this is nullptr.
+};
+
+/// A buffer that shaders can read and write as a `buffer` block, e.g. `layout(std430, binding = 0) buffer Particles { Particle particles[]; };`
+/// It is also a regular buffer, so you can bind its id() as a vertex buffer to draw what a compute shader wrote in it.
+/// Shader storage buffers require OpenGL 4.3, which MacOS doesn't have: check gl::ext::has_version(4, 3) before using them.
+class StorageBuffer {
+public:
+    explicit StorageBuffer(StorageBuffer_Descriptor const&);
+    ~StorageBuffer();
+    StorageBuffer(StorageBuffer const&)                    = delete; // You cannot copy
+    auto operator=(StorageBuffer const&) -> StorageBuffer& = delete; // a StorageBuffer. But you can move it, using std::move(my_buffer)
+    StorageBuffer(StorageBuffer&&) noexcept;
+    auto operator=(StorageBuffer&&) noexcept -> StorageBuffer&;
+
+    /// Binds the whole buffer to the block that has `layout(binding = binding)` in the shaders
+    void bind(GLuint binding) const;
+
+    /// Overwrites the content of the buffer, starting at `offset_in_bytes`
+    void upload(std::span<std::byte const> data, size_t offset_in_bytes = 0);
+    /// Copies the content of the buffer, starting at `offset_in_bytes`, into `data`. This waits for the GPU, so don't do it every frame.
+    void download(std::span<std::byte> data, size_t offset_in_bytes = 0) const;
+
+    auto id() const -> GLuint { return _id; }
+    auto size_in_bytes() const -> size_t { return _size_in_bytes; }
+
+private:
+    GLuint _id{};
+    size_t _size_in_bytes{};
+};
+
+} // namespace gl
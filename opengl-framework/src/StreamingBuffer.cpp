@@ -0,0 +1,143 @@
+#include "StreamingBuffer.hpp"
+#include <cassert>
+#include "extensions.hpp"
+#include "handle_error.hpp"
+#include "state_cache.hpp"
+
+namespace gl {
+
+/// Regions start on offsets that can be bound as uniform or storage buffers (256 is the largest alignment drivers require)
+static constexpr size_t region_alignment = 256;
+
+static auto align(size_t size) -> size_t
+{
+    return (size + region_alignment - 1) / region_alignment * region_alignment;
+}
+
+StreamingBuffer::StreamingBuffer(StreamingBuffer_Descriptor desc)
+    : _region_size_in_bytes{align(desc.region_size_in_bytes)}
+    , _fences(desc.regions_count, nullptr)
+{
+    assert(desc.region_size_in_bytes > 0 && "A StreamingBuffer can't be empty");
+    assert(desc.regions_count > 0 && "A StreamingBuffer needs at least one region");
+
+    auto const size = static_cast<GLsizeiptr>(_region_size_in_bytes * desc.regions_count);
+    glGenBuffers(1, &_id);
+    // Bound to GL_COPY_WRITE_BUFFER so that we don't mess with the bindings of the vertex arrays
+    state::bind_buffer(GL_COPY_WRITE_BUFFER, _id);
+    if (auto const buffer_storage = ext::buffer_storage())
+    {
+        GLbitfield const flags = GL_MAP_WRITE_BIT | ext::MAP_PERSISTENT_BIT | ext::MAP_COHERENT_BIT;
+        buffer_storage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+        _persistent_data = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+        if (_persistent_data == nullptr)
+            handle_error("[StreamingBuffer] Failed to map the buffer");
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+/// Blocks until the GPU has signaled the fence, if there is one
+static void wait_for(GLsync& fence)
+{
+    if (fence == nullptr)
+        return;
+    while (true)
+    {
+        // Flushing makes sure the fence will eventually be signaled, otherwise it could sit forever in the command queue
+        GLenum const status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000 /*1 second*/);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            break;
+        if (status == GL_WAIT_FAILED)
+            handle_error("[StreamingBuffer] Failed to wait for the GPU to be done with a region");
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+auto StreamingBuffer::map_region() -> std::span<std::byte>
+{
+    assert(!_is_mapped && "You must call unmap_region() and fence_region() before mapping the next region");
+    wait_for(_fences[_current_region]);
+    _is_mapped = true;
+
+    if (_persistent_data != nullptr)
+        return {_persistent_data + region_offset_in_bytes(), _region_size_in_bytes};
+
+    state::bind_buffer(GL_COPY_WRITE_BUFFER, _id);
+    // Unsynchronized: the fence already told us that the GPU is done with this region, the driver doesn't need to check it again
+    auto* const data = static_cast<std::byte*>(glMapBufferRange(
+        GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(region_offset_in_bytes()), static_cast<GLsizeiptr>(_region_size_in_bytes),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+    ));
+    if (data == nullptr)
+        handle_error("[StreamingBuffer] Failed to map a region of the buffer");
+    return {data, _region_size_in_bytes};
+}
+
+void StreamingBuffer::unmap_region()
+{
+    assert(_is_mapped && "You must call map_region() first");
+    _is_mapped = false;
+    if (_persistent_data != nullptr)
+        return; // Coherent mapping: what we wrote is visible to the draw calls issued from now on
+
+    state::bind_buffer(GL_COPY_WRITE_BUFFER, _id);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+}
+
+void StreamingBuffer::fence_region()
+{
+    assert(!_is_mapped && "You must call unmap_region() before drawing with the region, and thus before fencing it");
+    _fences[_current_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _current_region          = (_current_region + 1) % _fences.size();
+}
+
+void StreamingBuffer::destroy()
+{
+    for (GLsync const fence : _fences)
+        glDeleteSync(fence); // Silently ignores nullptr
+    state::delete_buffers({&_id, 1}); // Also unmaps it
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    destroy();
+}
+
+StreamingBuffer::StreamingBuffer(StreamingBuffer&& o) noexcept
+    : _id{o._id}
+    , _region_size_in_bytes{o._region_size_in_bytes}
+    , _current_region{o._current_region}
+    , _fences{std::move(o._fences)}
+    , _persistent_data{o._persistent_data}
+    , _is_mapped{o._is_mapped}
+{
+    o._id = 0;
+    o._fences.clear();
+    o._persistent_data = nullptr;
+}
+
+auto StreamingBuffer::operator=(StreamingBuffer&& o) noexcept -> StreamingBuffer&
+{
+    if (this != &o)
+    {
+        destroy();
+
+        _id                   = o._id;
+        _region_size_in_bytes = o._region_size_in_bytes;
+        _current_region       = o._current_region;
+        _fences               = std::move(o._fences);
+        _persistent_data      = o._persistent_data;
+        _is_mapped            = o._is_mapped;
+
+        o._id = 0;
+        o._fences.clear();
+        o._persistent_data = nullptr;
+    }
+    return *this;
+}
+
+} // namespace gl
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "glad/gl.h"
+
+namespace gl {
+
+struct StreamingBuffer_Descriptor {
+    size_t region_size_in_bytes{}; /// How much data you can write each frame
+    size_t regions_count{3};       /// How many frames the CPU can get ahead of the GPU before having to wait for it
+};
+
+/// A GPU buffer that you rewrite every frame, without ever reallocating it and without stalling on the GPU.
+/// It is split into regions that are used in turn: while the GPU reads the regions written during the previous frames, the CPU writes in the next one.
+/// A fence tells when the GPU is done with a region, so the CPU only waits when it gets more than regions_count frames ahead.
+///
+/// When the driver supports it (OpenGL 4.4 or GL_ARB_buffer_storage), the buffer stays mapped for its whole lifetime and you write straight into GPU-visible memory.
+/// Otherwise (e.g. on MacOS) each region is mapped and unmapped every frame, unsynchronized since the fences already tell when it is safe to write.
+///
+/// Each frame:
+///     std::span<std::byte> data = buffer.map_region(); // Write up to region_size_in_bytes() in data
+///     buffer.unmap_region();
+///     // Issue the draw calls that read the region, starting at region_offset_in_bytes() in the buffer
+///     buffer.fence_region();
+class StreamingBuffer {
+public:
+    explicit StreamingBuffer(StreamingBuffer_Descriptor);
+    ~StreamingBuffer();
+    StreamingBuffer(StreamingBuffer const&)                    = delete; // You cannot copy
+    auto operator=(StreamingBuffer const&) -> StreamingBuffer& = delete; // a StreamingBuffer. But you can move it, using std::move(my_buffer)
+    StreamingBuffer(StreamingBuffer&&) noexcept;
+    auto operator=(StreamingBuffer&&) noexcept -> StreamingBuffer&;
+
+    /// Waits until the GPU is done reading the current region (which it usually already is), and returns it so that you can write in it.
+    auto map_region() -> std::span<std::byte>;
+    /// Must be called once you are done writing in the region, before drawing with it.
+    void unmap_region();
+    /// Must be called once you have issued all the draw calls that read the region. Moves on to the next region.
+    void fence_region();
+
+    auto id() const -> GLuint { return _id; }
+    auto region_size_in_bytes() const -> size_t { return _region_size_in_bytes; }
+    /// Where the current region starts in the buffer. Use it as the offset of your vertex attributes, or in glBindBufferRange().
+    auto region_offset_in_bytes() const -> size_t { return _current_region * _region_size_in_bytes; }
+    auto is_persistently_mapped() const -> bool { return _persistent_data != nullptr; }
+
+private:
+    void destroy();
+
+private:
+    GLuint              _id{};
+    size_t              _region_size_in_bytes{};
+    size_t              _current_region{0};
+    std::vector<GLsync> _fences{};                 /// One per region, nullptr when the GPU is not reading it
+    std::byte*          _persistent_data{nullptr}; /// The whole buffer, when it is persistently mapped
+    bool                _is_mapped{false};
+};
+
+} // namespace gl
@@ -4,6 +4,7 @@
 #include <variant>
 #include "glad/gl.h"
 #include "glm/glm.hpp"
+#include "state_cache.hpp"
 
 namespace gl {
 
@@ -307,7 +308,7 @@ public:
     }
     ~UniqueTexture()
     {
-        glDeleteTextures(1, &_id);
+        state::delete_textures({&_id, 1});
     }
     UniqueTexture(UniqueTexture const&)                    = delete; // You cannot copy
     auto operator=(UniqueTexture const&) -> UniqueTexture& = delete; // a Texture. But you can move it, using std::move(my_texture)
@@ -320,7 +321,7 @@ public:
     {
         if (&o != this)
         {
-            glDeleteTextures(1, &_id);
+            state::delete_textures({&_id, 1});
             _id   = o._id;
             o._id = 0;
         }
@@ -0,0 +1,56 @@
+#include "UniformBuffer.hpp"
+#include <cassert>
+#include "state_cache.hpp"
+
+namespace gl {
+namespace internal {
+
+UniformBuffer_Base::UniformBuffer_Base(size_t size_in_bytes)
+    : _size_in_bytes{size_in_bytes}
+{
+    assert(size_in_bytes > 0 && "A UniformBuffer can't be empty");
+
+    glGenBuffers(1, &_id);
+    state::bind_buffer(GL_UNIFORM_BUFFER, _id);
+    // Written by the CPU, typically once per frame, and read by the GPU
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(size_in_bytes), nullptr, GL_DYNAMIC_DRAW);
+}
+
+void UniformBuffer_Base::bind(GLuint binding) const
+{
+    state::bind_buffer_base(GL_UNIFORM_BUFFER, binding, _id);
+}
+
+void UniformBuffer_Base::upload_bytes(std::span<std::byte const> data, size_t offset_in_bytes)
+{
+    assert(offset_in_bytes + data.size() <= _size_in_bytes && "Writing past the end of the buffer");
+    state::bind_buffer(GL_UNIFORM_BUFFER, _id);
+    glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(data.size()), data.data());
+}
+
+UniformBuffer_Base::~UniformBuffer_Base()
+{
+    state::delete_buffers({&_id, 1});
+}
+
+UniformBuffer_Base::UniformBuffer_Base(UniformBuffer_Base&& o) noexcept
+    : _id{o._id}
+    , _size_in_bytes{o._size_in_bytes}
+{
+    o._id = 0;
+}
+
+auto UniformBuffer_Base::operator=(UniformBuffer_Base&& o) noexcept -> UniformBuffer_Base&
+{
+    if (this != &o)
+    {
+        state::delete_buffers({&_id, 1});
+        _id            = o._id;
+        _size_in_bytes = o._size_in_bytes;
+        o._id          = 0;
+    }
+    return *this;
+}
+
+} // namespace internal
+} // namespace gl
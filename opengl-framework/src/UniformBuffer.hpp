@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include "glad/gl.h"
+
+namespace gl {
+
+namespace internal {
+/// The part of UniformBuffer<T> that doesn't depend on T
+class UniformBuffer_Base {
+public:
+    explicit UniformBuffer_Base(size_t size_in_bytes);
+    ~UniformBuffer_Base();
+    UniformBuffer_Base(UniformBuffer_Base const&)                    = delete; // You cannot copy
+    auto operator=(UniformBuffer_Base const&) -> UniformBuffer_Base& = delete; // a UniformBuffer. But you can move it, using std::move(my_buffer)
+    UniformBuffer_Base(UniformBuffer_Base&&) noexcept;
+    auto operator=(UniformBuffer_Base&&) noexcept -> UniformBuffer_Base&;
+
+    /// Binds the whole buffer to the binding point that Shader::bind_uniform_block() associated with the block
+    void bind(GLuint binding) const;
+
+    auto id() const -> GLuint { return _id; }
+    auto size_in_bytes() const -> size_t { return _size_in_bytes; }
+
+protected:
+    void upload_bytes(std::span<std::byte const> data, size_t offset_in_bytes);
+
+private:
+    GLuint _id{};
+    size_t _size_in_bytes{};
+};
+} // namespace internal
+
+struct UniformBuffer_Descriptor {
+    size_t count{1}; /// How many Ts the buffer contains. More than one for the blocks that contain an array, e.g. `uniform Circles { vec4 circles[8]; };`
+};
+
+/// A buffer that shaders read as a `uniform` block, e.g. `layout(std140) uniform Frame { float inverse_aspect_ratio; };`
+/// Unlike uniforms, which belong to a single program, a uniform block can be uploaded once and read by all the programs that are bound to the same binding point, see Shader::bind_uniform_block().
+/// T must match the std140 layout of the block. In particular std140 pads arrays and blocks to 16 bytes, so T must be padded too.
+template<typename T>
+class UniformBuffer : public internal::UniformBuffer_Base {
+    static_assert(sizeof(T) % 16 == 0, "std140 pads blocks and array elements to a multiple of 16 bytes, so T must be padded to a multiple of 16 bytes too");
+
+public:
+    explicit UniformBuffer(UniformBuffer_Descriptor const& desc = {})
+        : UniformBuffer_Base{desc.count * sizeof(T)}
+    {}
+
+    /// Overwrites the `index`-th T of the buffer
+    void upload(T const& value, size_t index = 0) { upload(std::span<T const>{&value, 1}, index); }
+    /// Overwrites the Ts of the buffer, starting at the `first_index`-th one
+    void upload(std::span<T const> values, size_t first_index = 0) { upload_bytes(std::as_bytes(values), first_index * sizeof(T)); }
+
+    auto size() const -> size_t { return size_in_bytes() / sizeof(T); }
+};
+
+} // namespace gl
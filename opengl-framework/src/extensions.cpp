@@ -0,0 +1,89 @@
+#include "extensions.hpp"
+#include <string>
+#include <vector>
+
+namespace gl {
+
+namespace {
+struct Extensions {
+    int                      major_version{};
+    int                      minor_version{};
+    std::vector<std::string> names{};
+
+    ext::BufferStorageFunction           buffer_storage{nullptr};
+    ext::MaxShaderCompilerThreadsFunction max_shader_compiler_threads{nullptr};
+};
+
+auto extensions() -> Extensions&
+{
+    static auto instance = Extensions{};
+    return instance;
+}
+} // namespace
+
+namespace ext {
+
+auto buffer_storage() -> BufferStorageFunction
+{
+    return extensions().buffer_storage;
+}
+
+auto max_shader_compiler_threads() -> MaxShaderCompilerThreadsFunction
+{
+    return extensions().max_shader_compiler_threads;
+}
+
+auto has_parallel_shader_compile() -> bool
+{
+    return extensions().max_shader_compiler_threads != nullptr;
+}
+
+auto has_version(int major, int minor) -> bool
+{
+    auto const& ext = extensions();
+    return ext.major_version > major || (ext.major_version == major && ext.minor_version >= minor);
+}
+
+auto has_extension(std::string_view name) -> bool
+{
+    for (auto const& extension_name : extensions().names)
+    {
+        if (extension_name == name)
+            return true;
+    }
+    return false;
+}
+
+} // namespace ext
+
+namespace internal {
+
+void load_extensions(GLADloadfunc load)
+{
+    auto& ext = extensions();
+    glGetIntegerv(GL_MAJOR_VERSION, &ext.major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &ext.minor_version);
+
+    int extensions_count{0};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions_count);
+    ext.names.clear();
+    for (int i = 0; i < extensions_count; ++i)
+        ext.names.emplace_back(reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)))); // NOLINT(*reinterpret-cast)
+
+    // A function pointer is not enough to know that a function is supported: some drivers return one for every name they are asked about
+    if (ext::has_version(4, 4) || ext::has_extension("GL_ARB_buffer_storage"))
+        ext.buffer_storage = reinterpret_cast<ext::BufferStorageFunction>(load("glBufferStorage")); // NOLINT(*reinterpret-cast)
+
+    if (ext::has_extension("GL_KHR_parallel_shader_compile"))
+        ext.max_shader_compiler_threads = reinterpret_cast<ext::MaxShaderCompilerThreadsFunction>(load("glMaxShaderCompilerThreadsKHR")); // NOLINT(*reinterpret-cast)
+    else if (ext::has_extension("GL_ARB_parallel_shader_compile"))
+        ext.max_shader_compiler_threads = reinterpret_cast<ext::MaxShaderCompilerThreadsFunction>(load("glMaxShaderCompilerThreadsARB")); // NOLINT(*reinterpret-cast)
+    else
+        ext.max_shader_compiler_threads = nullptr;
+    if (ext.max_shader_compiler_threads != nullptr)
+        ext.max_shader_compiler_threads(0xFFFFFFFF); // Means "as many as you want". Otherwise some drivers keep compiling on the calling thread.
+}
+
+} // namespace internal
+
+} // namespace gl
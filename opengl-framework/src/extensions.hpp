@@ -0,0 +1,43 @@
+#pragma once
+#include <string_view>
+#include "glad/gl.h"
+
+namespace gl {
+
+/// The OpenGL features newer than the 4.3 core profile glad loads for us, and that MacOS (stuck at OpenGL 4.1) doesn't have at all.
+/// They are loaded by gl::init() when the driver supports them. Always check that they are available before using them.
+namespace ext {
+
+// GL_ARB_buffer_storage (core since OpenGL 4.4)
+inline constexpr GLbitfield MAP_PERSISTENT_BIT  = 0x0040;
+inline constexpr GLbitfield MAP_COHERENT_BIT    = 0x0080;
+inline constexpr GLbitfield DYNAMIC_STORAGE_BIT = 0x0100;
+inline constexpr GLbitfield CLIENT_STORAGE_BIT  = 0x0200;
+using BufferStorageFunction = void(GLAD_API_PTR*)(GLenum target, GLsizeiptr size, void const* data, GLbitfield flags);
+
+/// nullptr iff the driver doesn't support GL_ARB_buffer_storage
+auto buffer_storage() -> BufferStorageFunction;
+
+// GL_KHR_parallel_shader_compile (or GL_ARB_parallel_shader_compile)
+inline constexpr GLenum MAX_SHADER_COMPILER_THREADS = 0x91B0;
+inline constexpr GLenum COMPLETION_STATUS           = 0x91B1;
+using MaxShaderCompilerThreadsFunction              = void(GLAD_API_PTR*)(GLuint count);
+
+/// nullptr iff the driver doesn't support GL_KHR_parallel_shader_compile. gl::init() already lets the driver use as many threads as it wants.
+auto max_shader_compiler_threads() -> MaxShaderCompilerThreadsFunction;
+/// True iff COMPLETION_STATUS can be queried with glGetShaderiv() and glGetProgramiv(), to know whether compiling or linking is over without waiting for it
+auto has_parallel_shader_compile() -> bool;
+
+/// True iff the OpenGL context is at least `major.minor`
+auto has_version(int major, int minor) -> bool;
+/// True iff the driver exposes the extension named `name` (e.g. "GL_ARB_buffer_storage")
+auto has_extension(std::string_view name) -> bool;
+
+} // namespace ext
+
+namespace internal {
+/// Called by gl::init(), right after glad has been loaded
+void load_extensions(GLADloadfunc);
+} // namespace internal
+
+} // namespace gl
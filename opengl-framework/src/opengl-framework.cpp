@@ -7,9 +7,11 @@
 #include "Camera.hpp"
 #include "GLFW/glfw3.h"
 #include "Shader.hpp"
+#include "extensions.hpp"
 #include "glfw.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "handle_error.hpp"
+#include "state_cache.hpp"
 
 namespace {
 struct Context { // NOLINT(*special-member-functions)
@@ -130,7 +132,7 @@ void scroll_callback(GLFWwindow*, double x_offset, double y_offset)
 }
 void framebuffer_resized_callback(GLFWwindow*, int width_in_pixels, int height_in_pixels)
 {
-    glViewport(0, 0, width_in_pixels, height_in_pixels);
+    gl::state::set_viewport({0, 0, width_in_pixels, height_in_pixels});
     for (auto const& callbacks : context().events_callbacks)
         callbacks.on_framebuffer_resized({.width_in_pixels = width_in_pixels, .height_in_pixels = height_in_pixels});
 }
@@ -170,6 +172,10 @@ void init(std::string_view window_title)
     glfwMakeContextCurrent(context().window);
     if (!gladLoadGL(glfwGetProcAddress))
         handle_error("[opengl_framework] Failed to initialize glad");
+    internal::load_extensions(glfwGetProcAddress);
+    // Sets what OpenGL starts with, so that gl::state never has to query it
+    state::bind_framebuffer(GL_FRAMEBUFFER, 0);
+    state::set_viewport({0, 0, framebuffer_width_in_pixels(), framebuffer_height_in_pixels()});
 
 #if !defined(NDEBUG) && !defined(__APPLE__)
     int flags; // NOLINT(*init-variables)
@@ -212,6 +218,7 @@ auto window_is_open() -> bool
     if (!context().is_first_frame)
         context().delta_time = time - context().last_time;
     context().last_time = time;
+    internal::end_state_frame();
 
     glfwSwapBuffers(context().window);
     glfwPollEvents();
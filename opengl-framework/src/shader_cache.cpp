@@ -0,0 +1,145 @@
+#include "shader_cache.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <vector>
+#include "exe_path/exe_path.h"
+
+namespace gl {
+
+namespace {
+
+auto shader_cache_folder() -> std::optional<std::filesystem::path>&
+{
+    static auto folder = std::optional<std::filesystem::path>{};
+    return folder;
+}
+
+/// Empty if the cache is disabled
+auto get_shader_cache_folder() -> std::filesystem::path const&
+{
+    if (!shader_cache_folder())
+        shader_cache_folder() = exe_path::dir() / "shader_cache";
+    return *shader_cache_folder();
+}
+
+auto cache_file_path(std::string_view key) -> std::filesystem::path
+{
+    return get_shader_cache_folder() / std::format("{}.bin", key);
+}
+
+/// 64-bit FNV-1a
+class Hasher {
+public:
+    void add(std::string_view str)
+    {
+        for (char const c : str)
+        {
+            _hash ^= static_cast<uint8_t>(c);
+            _hash *= 0x100000001b3u;
+        }
+        // Separates the parts, so that {"ab", "c"} and {"a", "bc"} don't hash the same
+        _hash ^= 0xFFu;
+        _hash *= 0x100000001b3u;
+    }
+    auto hash() const -> uint64_t { return _hash; }
+
+private:
+    uint64_t _hash{0xcbf29ce484222325u};
+};
+
+auto gl_string(GLenum name) -> std::string_view
+{
+    auto const* str = reinterpret_cast<char const*>(glGetString(name)); // NOLINT(*reinterpret-cast)
+    return str != nullptr ? str : "";
+}
+
+/// The formats in which the driver can save and load programs. Can be empty.
+auto program_binary_formats() -> std::vector<GLenum> const&
+{
+    static auto const formats = []() {
+        GLint formats_count{};
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_count);
+        auto res = std::vector<GLint>(static_cast<size_t>(formats_count));
+        if (!res.empty())
+            glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, res.data());
+        return std::vector<GLenum>(res.begin(), res.end());
+    }();
+    return formats;
+}
+
+} // namespace
+
+void set_shader_cache_folder(std::filesystem::path const& folder)
+{
+    shader_cache_folder() = folder;
+}
+
+namespace internal {
+
+auto shader_cache_key(std::initializer_list<std::string_view> parts) -> std::string
+{
+    auto hasher = Hasher{};
+    // A binary can only be loaded by the driver that created it
+    hasher.add(gl_string(GL_VENDOR));
+    hasher.add(gl_string(GL_RENDERER));
+    hasher.add(gl_string(GL_VERSION));
+    for (auto const part : parts)
+        hasher.add(part);
+    return std::format("{:016x}", hasher.hash());
+}
+
+void prepare_for_shader_cache(GLuint program)
+{
+    if (!get_shader_cache_folder().empty())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+auto load_from_shader_cache(GLuint program, std::string_view key) -> bool
+{
+    if (get_shader_cache_folder().empty())
+        return false;
+
+    auto file = std::ifstream{cache_file_path(key), std::ios::binary};
+    if (!file)
+        return false;
+    GLenum format{};
+    if (!file.read(reinterpret_cast<char*>(&format), sizeof(format))) // NOLINT(*reinterpret-cast)
+        return false;
+    if (std::find(program_binary_formats().begin(), program_binary_formats().end(), format) == program_binary_formats().end()) // glProgramBinary() would fail with an OpenGL error
+        return false;
+    auto const binary = std::vector<char>{std::istreambuf_iterator<char>{file}, {}};
+    if (binary.empty())
+        return false;
+
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success{};
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success == GL_TRUE;
+}
+
+void save_to_shader_cache(GLuint program, std::string_view key)
+{
+    if (get_shader_cache_folder().empty() || program_binary_formats().empty())
+        return;
+
+    GLint length{};
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    auto   binary = std::vector<char>(static_cast<size_t>(length));
+    GLenum format{};
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    auto error = std::error_code{};
+    std::filesystem::create_directories(get_shader_cache_folder(), error);
+    auto file = std::ofstream{cache_file_path(key), std::ios::binary};
+    file.write(reinterpret_cast<char const*>(&format), sizeof(format)); // NOLINT(*reinterpret-cast)
+    file.write(binary.data(), length);
+}
+
+} // namespace internal
+
+} // namespace gl
@@ -0,0 +1,25 @@
+#pragma once
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include "glad/gl.h"
+
+namespace gl {
+
+/// Linked shaders are saved in this folder, and loaded from it the next time the same shader is created with the same driver, which is much faster than compiling it again.
+/// Defaults to a "shader_cache" folder next to the executable. An empty path disables the cache.
+void set_shader_cache_folder(std::filesystem::path const&);
+
+namespace internal {
+/// Identifies a program by everything that affects its linking: its sources and options (`parts`), and the driver that links it
+auto shader_cache_key(std::initializer_list<std::string_view> parts) -> std::string;
+/// Must be called before linking, for the program to be saved in the cache afterwards
+void prepare_for_shader_cache(GLuint program);
+/// Returns false if the program is not in the cache, or if the driver rejected the cached binary (e.g. because the driver has been updated since). In that case the program must be compiled and linked as usual.
+auto load_from_shader_cache(GLuint program, std::string_view key) -> bool;
+/// Saves a successfully linked program. Failing to do so is not an error: the program will simply be compiled again next time.
+void save_to_shader_cache(GLuint program, std::string_view key);
+} // namespace internal
+
+} // namespace gl
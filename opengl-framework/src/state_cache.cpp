@@ -0,0 +1,287 @@
+#include "state_cache.hpp"
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <vector>
+
+namespace gl {
+
+namespace {
+
+struct Binding {
+    GLenum target;
+    GLuint index; /// Of the indexed binding point, or of the texture unit. 0 for the other bindings.
+    GLuint object;
+};
+
+struct FramebufferBinding {
+    GLuint               draw_framebuffer;
+    GLuint               read_framebuffer;
+    std::array<GLint, 4> viewport;
+};
+
+/// Every member is empty until it has been set, so that the first call is always made
+struct State {
+    std::optional<GLuint>               program{};
+    std::optional<GLuint>               vertex_array{};
+    std::vector<Binding>                buffers{};
+    std::vector<Binding>                indexed_buffers{};
+    std::vector<Binding>                textures{};
+    std::optional<GLuint>               active_texture_unit{};
+    std::optional<bool>                 blending{};
+    std::optional<std::array<GLenum, 2>> blend_function{};
+    std::optional<std::array<GLint, 4>> viewport{};
+    std::optional<GLuint>               draw_framebuffer{};
+    std::optional<GLuint>               read_framebuffer{};
+    std::vector<FramebufferBinding>     framebuffers_stack{};
+
+    state::Stats current_frame_stats{};
+    state::Stats last_frame_stats{};
+};
+
+auto current_state() -> State&
+{
+    static auto instance = State{};
+    return instance;
+}
+
+/// Returns true if `cached` is already `value`, in which case the call can be skipped. Otherwise `cached` becomes `value`.
+template<typename T>
+auto is_unchanged(std::optional<T>& cached, T const& value) -> bool
+{
+    auto& stats = current_state().current_frame_stats;
+    if (cached == value)
+    {
+        stats.calls_saved++;
+        return true;
+    }
+    cached = value;
+    stats.calls_made++;
+    return false;
+}
+
+auto is_unchanged(std::vector<Binding>& bindings, Binding const& binding) -> bool
+{
+    auto const it = std::find_if(bindings.begin(), bindings.end(), [&](Binding const& b) {
+        return b.target == binding.target && b.index == binding.index;
+    });
+    auto cached = it != bindings.end() ? std::optional<GLuint>{it->object} : std::nullopt;
+    if (is_unchanged(cached, binding.object))
+        return true;
+    if (it != bindings.end())
+        it->object = binding.object;
+    else
+        bindings.push_back(binding);
+    return false;
+}
+
+/// Only queries OpenGL when the binding has never been set through gl::state
+auto current_framebuffer(std::optional<GLuint>& cached, GLenum binding) -> GLuint
+{
+    if (!cached)
+    {
+        GLint framebuffer{};
+        glGetIntegerv(binding, &framebuffer);
+        cached = static_cast<GLuint>(framebuffer);
+    }
+    return *cached;
+}
+
+void forget(std::vector<Binding>& bindings, std::span<GLuint const> objects)
+{
+    for (auto& binding : bindings)
+    {
+        if (std::find(objects.begin(), objects.end(), binding.object) != objects.end())
+            binding.object = 0;
+    }
+}
+
+} // namespace
+
+namespace state {
+
+void use_program(GLuint program)
+{
+    if (!is_unchanged(current_state().program, program))
+        glUseProgram(program);
+}
+
+void bind_vertex_array(GLuint vertex_array)
+{
+    if (!is_unchanged(current_state().vertex_array, vertex_array))
+        glBindVertexArray(vertex_array);
+}
+
+void bind_buffer(GLenum target, GLuint buffer)
+{
+    if (!is_unchanged(current_state().buffers, {target, 0, buffer}))
+        glBindBuffer(target, buffer);
+}
+
+void bind_buffer_base(GLenum target, GLuint index, GLuint buffer)
+{
+    auto& state = current_state();
+    if (is_unchanged(state.indexed_buffers, {target, index, buffer}))
+        return;
+    glBindBufferBase(target, index, buffer);
+    // glBindBufferBase() binds to the generic binding point too
+    auto const generic = std::find_if(state.buffers.begin(), state.buffers.end(), [&](Binding const& b) { return b.target == target; });
+    if (generic != state.buffers.end())
+        generic->object = buffer;
+    else
+        state.buffers.push_back({target, 0, buffer});
+}
+
+void bind_texture(GLuint unit, GLenum target, GLuint texture)
+{
+    auto& state = current_state();
+    if (!is_unchanged(state.active_texture_unit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    if (!is_unchanged(state.textures, {target, unit, texture}))
+        glBindTexture(target, texture);
+}
+
+void bind_framebuffer(GLenum target, GLuint framebuffer)
+{
+    auto& state = current_state();
+    if (target == GL_DRAW_FRAMEBUFFER)
+    {
+        if (!is_unchanged(state.draw_framebuffer, framebuffer))
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        return;
+    }
+    if (target == GL_READ_FRAMEBUFFER)
+    {
+        if (!is_unchanged(state.read_framebuffer, framebuffer))
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        return;
+    }
+    // GL_FRAMEBUFFER binds both with a single call
+    auto both = state.draw_framebuffer && state.read_framebuffer
+                    ? std::optional<std::array<GLuint, 2>>{{*state.draw_framebuffer, *state.read_framebuffer}}
+                    : std::nullopt;
+    if (is_unchanged(both, {framebuffer, framebuffer}))
+        return;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    state.draw_framebuffer = framebuffer;
+    state.read_framebuffer = framebuffer;
+}
+
+void set_blending(bool enabled)
+{
+    if (is_unchanged(current_state().blending, enabled))
+        return;
+    if (enabled)
+        glEnable(GL_BLEND);
+    else
+        glDisable(GL_BLEND);
+}
+
+void set_blend_function(GLenum source_factor, GLenum destination_factor)
+{
+    if (!is_unchanged(current_state().blend_function, {source_factor, destination_factor}))
+        glBlendFunc(source_factor, destination_factor);
+}
+
+void set_viewport(std::array<GLint, 4> const& viewport)
+{
+    if (!is_unchanged(current_state().viewport, viewport))
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+auto viewport() -> std::array<GLint, 4>
+{
+    auto& state = current_state();
+    if (!state.viewport)
+    {
+        state.viewport.emplace();
+        glGetIntegerv(GL_VIEWPORT, state.viewport->data());
+    }
+    return *state.viewport;
+}
+
+void push_framebuffer(GLuint framebuffer, std::array<GLint, 4> const& viewport)
+{
+    auto& state = current_state();
+    state.framebuffers_stack.push_back({
+        .draw_framebuffer = current_framebuffer(state.draw_framebuffer, GL_DRAW_FRAMEBUFFER_BINDING),
+        .read_framebuffer = current_framebuffer(state.read_framebuffer, GL_READ_FRAMEBUFFER_BINDING),
+        .viewport         = state::viewport(),
+    });
+    bind_framebuffer(GL_FRAMEBUFFER, framebuffer);
+    set_viewport(viewport);
+}
+
+void pop_framebuffer()
+{
+    auto& state = current_state();
+    assert(!state.framebuffers_stack.empty() && "pop_framebuffer() must match a push_framebuffer()");
+    auto const previous = state.framebuffers_stack.back();
+    state.framebuffers_stack.pop_back();
+    bind_framebuffer(GL_DRAW_FRAMEBUFFER, previous.draw_framebuffer);
+    bind_framebuffer(GL_READ_FRAMEBUFFER, previous.read_framebuffer);
+    set_viewport(previous.viewport);
+}
+
+void delete_vertex_arrays(std::span<GLuint const> vertex_arrays)
+{
+    auto& state = current_state();
+    if (state.vertex_array && std::find(vertex_arrays.begin(), vertex_arrays.end(), *state.vertex_array) != vertex_arrays.end())
+        state.vertex_array = 0;
+    glDeleteVertexArrays(static_cast<GLsizei>(vertex_arrays.size()), vertex_arrays.data());
+}
+
+void delete_buffers(std::span<GLuint const> buffers)
+{
+    forget(current_state().buffers, buffers);
+    forget(current_state().indexed_buffers, buffers);
+    glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+}
+
+void delete_textures(std::span<GLuint const> textures)
+{
+    forget(current_state().textures, textures);
+    glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+}
+
+void delete_framebuffers(std::span<GLuint const> framebuffers)
+{
+    auto& state = current_state();
+    // Deleting a bound framebuffer binds the default one instead
+    for (auto* const cached : {&state.draw_framebuffer, &state.read_framebuffer})
+    {
+        if (*cached && std::find(framebuffers.begin(), framebuffers.end(), **cached) != framebuffers.end())
+            *cached = 0;
+    }
+    glDeleteFramebuffers(static_cast<GLsizei>(framebuffers.size()), framebuffers.data());
+}
+
+void invalidate()
+{
+    auto& state = current_state();
+    state       = State{
+              .framebuffers_stack  = std::move(state.framebuffers_stack),
+              .current_frame_stats = state.current_frame_stats,
+              .last_frame_stats    = state.last_frame_stats,
+    };
+}
+
+auto last_frame_stats() -> Stats
+{
+    return current_state().last_frame_stats;
+}
+
+} // namespace state
+
+namespace internal {
+
+void end_state_frame()
+{
+    auto& state               = current_state();
+    state.last_frame_stats    = state.current_frame_stats;
+    state.current_frame_stats = {};
+}
+
+} // namespace internal
+
+} // namespace gl
@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <span>
+#include "glad/gl.h"
+
+namespace gl {
+
+/// Remembers the OpenGL state set through it, and skips the calls that wouldn't change anything.
+/// All the binds of the framework go through it. If you change the same state with OpenGL functions directly, call state::invalidate() afterwards.
+namespace state {
+
+void use_program(GLuint program);
+void bind_vertex_array(GLuint vertex_array);
+/// Not for GL_ELEMENT_ARRAY_BUFFER: it is part of the state of the bound vertex array, so bind it with glBindBuffer() directly
+void bind_buffer(GLenum target, GLuint buffer);
+/// Also binds the buffer to `target`, like glBindBufferBase() does
+void bind_buffer_base(GLenum target, GLuint index, GLuint buffer);
+/// Binds the texture to the texture unit `unit` (0 for GL_TEXTURE0 etc.), which is the active unit afterwards
+void bind_texture(GLuint unit, GLenum target, GLuint texture);
+/// `target` is GL_DRAW_FRAMEBUFFER, GL_READ_FRAMEBUFFER, or GL_FRAMEBUFFER for both
+void bind_framebuffer(GLenum target, GLuint framebuffer);
+void set_blending(bool enabled);
+void set_blend_function(GLenum source_factor, GLenum destination_factor);
+void set_viewport(std::array<GLint, 4> const& viewport);
+auto viewport() -> std::array<GLint, 4>;
+
+/// Binds `framebuffer` for drawing and reading, with the given viewport, until the matching pop_framebuffer().
+/// The bindings to restore are remembered in a stack, so that offscreen passes can be nested without ever querying OpenGL.
+void push_framebuffer(GLuint framebuffer, std::array<GLint, 4> const& viewport);
+/// Restores the framebuffers and viewport that were bound before the last push_framebuffer()
+void pop_framebuffer();
+
+/// Use these instead of glDelete*(): OpenGL unbinds the objects it deletes, and might reuse their ids for new objects, so the state must forget about them too
+void delete_vertex_arrays(std::span<GLuint const>);
+void delete_buffers(std::span<GLuint const>);
+void delete_textures(std::span<GLuint const>);
+void delete_framebuffers(std::span<GLuint const>);
+/// Forgets all the state, so that the next calls will all be made. The framebuffers stack is kept.
+void invalidate();
+
+struct Stats {
+    int calls_made{0};
+    int calls_saved{0}; /// Calls that have been skipped because they wouldn't have changed the state
+};
+/// During the previous frame
+auto last_frame_stats() -> Stats;
+
+} // namespace state
+
+namespace internal {
+/// Called by gl::window_is_open() at the end of each frame
+void end_state_frame();
+} // namespace internal
+
+} // namespace gl
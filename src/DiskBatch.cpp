@@ -0,0 +1,293 @@
+#include "DiskBatch.hpp"
+#include <array>
+#include <cstddef>
+#include "frame_uniforms.hpp"
+
+namespace utils {
+
+static auto make_quad_shader() -> gl::Shader
+{
+    auto shader = gl::Shader{
+        gl::Shader_Descriptor{
+            .vertex   = gl::ShaderSource::Code{std::string{"#version 410\n"} + frame_uniforms_glsl + R"GLSL(
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec2 in_uv;
+layout(location = 2) in vec2 in_center;
+layout(location = 3) in float in_radius;
+layout(location = 4) in vec4 in_color;
+
+out vec2 v_uv;
+out vec4 v_color;
+
+void main()
+{
+    vec2 position = in_center + in_radius * in_position;
+
+    gl_Position = vec4(position * vec2(u_frame.inverse_aspect_ratio, 1.), 0., 1.);
+    v_uv = in_uv;
+    v_color = in_color;
+}
+)GLSL"},
+            .fragment = gl::ShaderSource::Code({R"GLSL(
+#version 410
+
+out vec4 out_color;
+
+in vec2 v_uv;
+in vec4 v_color;
+
+void main()
+{
+    vec2 dir = v_uv - vec2(0.5);
+    if (dot(dir, dir) > 0.25)
+        discard;
+    out_color = v_color;
+}
+)GLSL"}),
+            .compile_asynchronously = true,
+        }
+    };
+    use_frame_uniforms(shader);
+    return shader;
+}
+
+/// Each disk is a single point, whose size is the diameter of the disk in pixels
+static auto make_point_shader() -> gl::Shader
+{
+    auto shader = gl::Shader{
+        gl::Shader_Descriptor{
+            .vertex   = gl::ShaderSource::Code{std::string{"#version 410\n"} + frame_uniforms_glsl + R"GLSL(
+layout(location = 2) in vec2 in_center;
+layout(location = 3) in float in_radius;
+layout(location = 4) in vec4 in_color;
+
+out vec4 v_color;
+
+void main()
+{
+    gl_Position = vec4(in_center * vec2(u_frame.inverse_aspect_ratio, 1.), 0., 1.);
+    // The framebuffer spans 2 units vertically
+    gl_PointSize = in_radius * u_frame.framebuffer_height_in_pixels;
+    v_color = in_color;
+}
+)GLSL"},
+            .fragment = gl::ShaderSource::Code({R"GLSL(
+#version 410
+
+out vec4 out_color;
+
+in vec4 v_color;
+
+void main()
+{
+    vec2 dir = gl_PointCoord - vec2(0.5);
+    if (dot(dir, dir) > 0.25)
+        discard;
+    out_color = v_color;
+}
+)GLSL"}),
+            .compile_asynchronously = true,
+        }
+    };
+    use_frame_uniforms(shader);
+    return shader;
+}
+
+static auto max_point_size() -> float
+{
+    static float const size = []() {
+        GLfloat range[2]; // NOLINT(*avoid-c-arrays)
+        glGetFloatv(GL_POINT_SIZE_RANGE, range);
+        return range[1];
+    }();
+    return size;
+}
+
+DiskBatch::DiskBatch(DiskBatch_Descriptor const& desc)
+    : _primitive{desc.primitive}
+    , _quad_shader{make_quad_shader()}
+    , _point_shader{make_point_shader()}
+    , _instance_buffer{{.region_size_in_bytes = std::max<size_t>(desc.capacity, 1) * sizeof(Instance)}}
+    , _capacity{std::max<size_t>(desc.capacity, 1)} // Otherwise doubling it when the batch is full would never make room
+{
+    static constexpr auto square_vertices = std::array{
+        -1.f, -1.f, 0.f, 0.f, //
+        +1.f, -1.f, 1.f, 0.f, //
+        +1.f, +1.f, 1.f, 1.f, //
+        -1.f, +1.f, 0.f, 1.f  //
+    };
+    static constexpr auto square_indices = std::array<uint32_t, 6>{0, 1, 2, 0, 2, 3};
+
+    glGenVertexArrays(1, &_quad_vertex_array);
+    gl::state::bind_vertex_array(_quad_vertex_array);
+
+    { // Per-vertex attributes: the square every disk is cut out of
+        glGenBuffers(1, &_square_vertex_buffer);
+        gl::state::bind_buffer(GL_ARRAY_BUFFER, _square_vertex_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(square_vertices), square_vertices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void*>(0)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void*>(2 * sizeof(float))); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+    }
+
+    { // Per-instance attributes, advancing once per disk instead of once per vertex. They point into a different region of the instance buffer each frame, so they are set by draw_instances()
+        for (GLuint const index : {2u, 3u, 4u})
+        {
+            glEnableVertexAttribArray(index);
+            glVertexAttribDivisor(index, 1);
+        }
+    }
+
+    { // Index Buffer
+        glGenBuffers(1, &_index_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(square_indices), square_indices.data(), GL_STATIC_DRAW);
+    }
+
+    { // Points: the same attributes, but advancing once per vertex
+        glGenVertexArrays(1, &_point_vertex_array);
+        gl::state::bind_vertex_array(_point_vertex_array);
+        for (GLuint const index : {2u, 3u, 4u})
+            glEnableVertexAttribArray(index);
+        // Lets the point shader set gl_PointSize. Nothing ever disables it, so it is enabled once and for all.
+        glEnable(GL_PROGRAM_POINT_SIZE);
+    }
+}
+
+void DiskBatch::add(glm::vec2 const& position, float radius, glm::vec4 const& color)
+{
+    if (_count == _instances.size())
+    {
+        if (!_instances.empty())
+        {
+            // The region is full: draw what it contains, and carry on in a bigger buffer
+            draw_instances();
+            _capacity *= 2;
+        }
+        map_instances();
+    }
+    _instances[_count++] = Instance{position, radius, glm::u8vec4{glm::round(glm::clamp(color, 0.f, 1.f) * 255.f)}};
+    _max_radius          = std::max(_max_radius, radius);
+}
+
+void DiskBatch::map_instances()
+{
+    if (_instance_buffer.region_size_in_bytes() < _capacity * sizeof(Instance))
+        _instance_buffer = gl::StreamingBuffer{{.region_size_in_bytes = _capacity * sizeof(Instance)}};
+
+    std::span<std::byte> const region = _instance_buffer.map_region();
+    _instances  = {reinterpret_cast<Instance*>(region.data()), region.size() / sizeof(Instance)}; // NOLINT(*reinterpret-cast)
+    _count      = 0;
+    _max_radius = 0.f;
+}
+
+auto DiskBatch::can_draw_points() const -> bool
+{
+    return _primitive == DiskPrimitive::Point
+           && _max_radius * static_cast<float>(gl::framebuffer_height_in_pixels()) <= max_point_size();
+}
+
+/// Points the instance attributes of the bound vertex array to the instances that start at `offset` in the bound buffer
+static void set_instance_attributes(size_t offset, size_t stride, size_t position_offset, size_t radius_offset, size_t color_offset)
+{
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stride), reinterpret_cast<void*>(offset + position_offset));     // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stride), reinterpret_cast<void*>(offset + radius_offset));       // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, static_cast<GLsizei>(stride), reinterpret_cast<void*>(offset + color_offset)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+}
+
+void DiskBatch::draw_instances()
+{
+    _instance_buffer.unmap_region();
+    if (_count != 0)
+    {
+        bool const as_points = can_draw_points();
+        auto const& shader   = as_points ? _point_shader : _quad_shader;
+        shader.bind();
+
+        gl::state::bind_vertex_array(as_points ? _point_vertex_array : _quad_vertex_array);
+        gl::state::bind_buffer(GL_ARRAY_BUFFER, _instance_buffer.id());
+        set_instance_attributes(_instance_buffer.region_offset_in_bytes(), sizeof(Instance), offsetof(Instance, position), offsetof(Instance, radius), offsetof(Instance, color));
+
+        if (as_points)
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(_count));
+        else
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, reinterpret_cast<void*>(0), static_cast<GLsizei>(_count)); // NOLINT(*reinterpret-cast)
+    }
+    _instance_buffer.fence_region();
+    _instances = {};
+    _count     = 0;
+}
+
+void DiskBatch::draw()
+{
+    if (_instances.empty())
+        return;
+    draw_instances();
+}
+
+void DiskBatch::destroy()
+{
+    gl::state::delete_vertex_arrays({&_quad_vertex_array, 1});
+    gl::state::delete_vertex_arrays({&_point_vertex_array, 1});
+    gl::state::delete_buffers({&_square_vertex_buffer, 1});
+    gl::state::delete_buffers({&_index_buffer, 1});
+}
+
+DiskBatch::~DiskBatch()
+{
+    destroy();
+}
+
+DiskBatch::DiskBatch(DiskBatch&& o) noexcept
+    : _primitive{o._primitive}
+    , _quad_shader{std::move(o._quad_shader)}
+    , _point_shader{std::move(o._point_shader)}
+    , _instance_buffer{std::move(o._instance_buffer)}
+    , _instances{o._instances}
+    , _count{o._count}
+    , _capacity{o._capacity}
+    , _max_radius{o._max_radius}
+    , _quad_vertex_array{o._quad_vertex_array}
+    , _point_vertex_array{o._point_vertex_array}
+    , _square_vertex_buffer{o._square_vertex_buffer}
+    , _index_buffer{o._index_buffer}
+{
+    o._instances            = {};
+    o._count                = 0;
+    o._quad_vertex_array    = 0;
+    o._point_vertex_array   = 0;
+    o._square_vertex_buffer = 0;
+    o._index_buffer         = 0;
+}
+
+auto DiskBatch::operator=(DiskBatch&& o) noexcept -> DiskBatch&
+{
+    if (this != &o)
+    {
+        destroy();
+
+        _primitive            = o._primitive;
+        _quad_shader          = std::move(o._quad_shader);
+        _point_shader         = std::move(o._point_shader);
+        _instance_buffer      = std::move(o._instance_buffer);
+        _instances            = o._instances;
+        _count                = o._count;
+        _capacity             = o._capacity;
+        _max_radius           = o._max_radius;
+        _quad_vertex_array    = o._quad_vertex_array;
+        _point_vertex_array   = o._point_vertex_array;
+        _square_vertex_buffer = o._square_vertex_buffer;
+        _index_buffer         = o._index_buffer;
+
+        o._instances            = {};
+        o._count                = 0;
+        o._quad_vertex_array    = 0;
+        o._point_vertex_array   = 0;
+        o._square_vertex_buffer = 0;
+        o._index_buffer         = 0;
+    }
+    return *this;
+}
+
+} // namespace utils
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <span>
+#include "glm/glm.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+
+namespace utils {
+
+enum class DiskPrimitive {
+    /// Each disk is cut out of a square made of two triangles. Works for disks of any size.
+    Quad,
+    /// Each disk is cut out of a single point sprite: 1 vertex per disk instead of 4, but points can't be bigger than GL_POINT_SIZE_RANGE allows.
+    /// A batch containing bigger disks falls back to quads.
+    Point,
+};
+
+struct DiskBatch_Descriptor {
+    size_t        capacity{1024}; /// How many disks can be drawn per frame with a single draw call (at least 1). If you add more, the batch grows for the next frames.
+    DiskPrimitive primitive{DiskPrimitive::Quad};
+};
+
+/// Draws many disks with a single draw call.
+/// Add the disks of the frame with add(), then draw() draws them all at once. The GL calls don't depend on the number of disks.
+/// add() writes straight into a gl::StreamingBuffer, so the disks never have to be copied or uploaded.
+/// The shaders read the aspect ratio from the FrameUniforms, which must be bound to frame_uniforms_binding.
+class DiskBatch {
+public:
+    explicit DiskBatch(DiskBatch_Descriptor const& = {});
+    ~DiskBatch();
+    DiskBatch(DiskBatch const&)                    = delete; // You cannot copy
+    auto operator=(DiskBatch const&) -> DiskBatch& = delete; // a DiskBatch. But you can move it, using std::move(my_batch)
+    DiskBatch(DiskBatch&&) noexcept;
+    auto operator=(DiskBatch&&) noexcept -> DiskBatch&;
+
+    void add(glm::vec2 const& position, float radius, glm::vec4 const& color);
+    /// Takes effect from the next frame
+    void reserve(size_t disks_count) { _capacity = std::max(_capacity, disks_count); }
+    /// Removes the disks added since the last draw()
+    void clear() { _count = 0; }
+    auto size() const -> size_t { return _count; }
+
+    /// Draws the disks added since the last draw(), and starts a new batch
+    void draw();
+
+private:
+    /// Per-instance vertex attributes
+    struct Instance {
+        glm::vec2   position;
+        float       radius;
+        glm::u8vec4 color; /// Normalized, so that an Instance takes 16 bytes instead of 28 with a float color
+    };
+
+    /// Starts writing in the next region of the instance buffer
+    void map_instances();
+    /// Draws the instances written in the current region, and releases it
+    void draw_instances();
+    /// True iff all the disks of the current region can be drawn as points
+    auto can_draw_points() const -> bool;
+    void destroy();
+
+private:
+    DiskPrimitive       _primitive;
+    gl::Shader          _quad_shader;
+    gl::Shader          _point_shader;
+    gl::StreamingBuffer _instance_buffer;
+    std::span<Instance> _instances{}; /// The region of _instance_buffer we are writing in, empty when none is mapped
+    size_t              _count{0};
+    size_t              _capacity{};
+    float               _max_radius{0.f}; /// Of the disks in the current region
+
+    GLuint _quad_vertex_array{};  /// One instance per disk
+    GLuint _point_vertex_array{}; /// One vertex per disk
+    GLuint _square_vertex_buffer{};
+    GLuint _index_buffer{};
+};
+
+} // namespace utils
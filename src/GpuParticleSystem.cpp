@@ -0,0 +1,168 @@
+#include "GpuParticleSystem.hpp"
+#include <algorithm>
+#include "gpu_particles.hpp"
+
+namespace utils {
+
+/// The storage buffers the compute shader works on
+static constexpr char const* storage_buffers_glsl = R"GLSL(
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) buffer Particles { Particle particles[]; };
+layout(std430, binding = 1) readonly buffer Segments { vec4 segments[]; };
+layout(std430, binding = 2) readonly buffer Circles { vec4 circles[]; };
+
+uniform int u_particles_count;
+)GLSL";
+
+/// Runs update_particle() on each particle of the storage buffer
+static constexpr char const* update_main_glsl = R"GLSL(
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i < uint(u_particles_count))
+        particles[i] = update_particle(particles[i], i);
+}
+)GLSL";
+
+/// A storage buffer can't be empty, so empty arrays still get one (unused) element
+template<typename T>
+static auto make_storage_buffer(std::vector<T> const& data) -> gl::StorageBuffer
+{
+    return gl::StorageBuffer{{
+        .size_in_bytes = std::max<size_t>(data.size(), 1) * sizeof(T),
+        .data          = data.empty() ? nullptr : data.data(),
+    }};
+}
+
+static auto make_particles_buffer(std::span<sim::Particle const> particles) -> gl::StorageBuffer
+{
+    auto gpu_particles = std::vector<GpuParticle>{};
+    gpu_particles.reserve(particles.size());
+    for (auto const& particle : particles)
+        gpu_particles.push_back(to_gpu_particle(particle));
+    return make_storage_buffer(gpu_particles);
+}
+
+static auto make_segments_buffer(std::vector<sim::Segment> const& segments) -> gl::StorageBuffer
+{
+    auto data = std::vector<glm::vec4>{};
+    for (auto const& segment : segments)
+        data.emplace_back(segment.start, segment.end);
+    return make_storage_buffer(data);
+}
+
+static auto make_circles_buffer(std::vector<sim::Circle> const& circles) -> gl::StorageBuffer
+{
+    auto data = std::vector<glm::vec4>{};
+    for (auto const& circle : circles)
+        data.emplace_back(circle.center, circle.radius, 0.f);
+    return make_storage_buffer(data);
+}
+
+GpuParticleSystem::GpuParticleSystem(GpuParticleSystem_Descriptor const& desc)
+    : _particles_count{desc.particles.size()}
+    , _spawn_half_size{desc.spawn_half_size}
+    , _particles{make_particles_buffer(desc.particles)}
+    , _segments{make_segments_buffer(desc.obstacles.segments)}
+    , _circles{make_circles_buffer(desc.obstacles.circles)}
+    , _segments_count{static_cast<int>(desc.obstacles.segments.size())}
+    , _circles_count{static_cast<int>(desc.obstacles.circles.size())}
+    , _update_shader{{.compute = gl::ShaderSource::Code{particle_shaders::header(430) + particle_shaders::particle_struct + storage_buffers_glsl + particle_shaders::update_particle + update_main_glsl}}}
+    , _render_shader{particle_shaders::make_render_shader()}
+{
+    glGenVertexArrays(1, &_vertex_array);
+    gl::state::bind_vertex_array(_vertex_array);
+    particle_shaders::set_attributes(_particles.id(), 1);
+}
+
+auto GpuParticleSystem::is_supported() -> bool
+{
+    return gl::ext::has_version(4, 3);
+}
+
+void GpuParticleSystem::update(float dt)
+{
+    _particles.bind(0);
+    _segments.bind(1);
+    _circles.bind(2);
+
+    _update_shader.bind();
+    _update_shader.set_uniform("u_particles_count", static_cast<int>(_particles_count));
+    _update_shader.set_uniform("u_segments_count", _segments_count);
+    _update_shader.set_uniform("u_circles_count", _circles_count);
+    _update_shader.set_uniform("u_dt", dt);
+    _update_shader.set_uniform("u_seed", static_cast<int>(_steps_count++));
+    _update_shader.set_uniform("u_spawn_half_size", _spawn_half_size);
+    _update_shader.dispatch_for(static_cast<GLuint>(_particles_count));
+
+    // The next update reads what this one wrote, and draw() reads it as vertex attributes
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GpuParticleSystem::draw(float interpolation_factor, float radius) const
+{
+    gl::state::bind_vertex_array(_vertex_array);
+    particle_shaders::draw(_render_shader, _particles_count, interpolation_factor, radius);
+}
+
+auto GpuParticleSystem::read_particles() const -> std::vector<sim::Particle>
+{
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    auto gpu_particles = std::vector<GpuParticle>(_particles_count);
+    _particles.download(std::as_writable_bytes(std::span{gpu_particles}));
+
+    auto particles = std::vector<sim::Particle>{};
+    particles.reserve(gpu_particles.size());
+    for (auto const& particle : gpu_particles)
+        particles.push_back(to_particle(particle));
+    return particles;
+}
+
+GpuParticleSystem::~GpuParticleSystem()
+{
+    gl::state::delete_vertex_arrays({&_vertex_array, 1});
+}
+
+GpuParticleSystem::GpuParticleSystem(GpuParticleSystem&& o) noexcept
+    : _particles_count{o._particles_count}
+    , _spawn_half_size{o._spawn_half_size}
+    , _steps_count{o._steps_count}
+    , _particles{std::move(o._particles)}
+    , _segments{std::move(o._segments)}
+    , _circles{std::move(o._circles)}
+    , _segments_count{o._segments_count}
+    , _circles_count{o._circles_count}
+    , _update_shader{std::move(o._update_shader)}
+    , _render_shader{std::move(o._render_shader)}
+    , _vertex_array{o._vertex_array}
+{
+    o._particles_count = 0;
+    o._vertex_array    = 0;
+}
+
+auto GpuParticleSystem::operator=(GpuParticleSystem&& o) noexcept -> GpuParticleSystem&
+{
+    if (this != &o)
+    {
+        gl::state::delete_vertex_arrays({&_vertex_array, 1});
+
+        _particles_count = o._particles_count;
+        _spawn_half_size = o._spawn_half_size;
+        _steps_count     = o._steps_count;
+        _particles       = std::move(o._particles);
+        _segments        = std::move(o._segments);
+        _circles         = std::move(o._circles);
+        _segments_count  = o._segments_count;
+        _circles_count   = o._circles_count;
+        _update_shader   = std::move(o._update_shader);
+        _render_shader   = std::move(o._render_shader);
+        _vertex_array    = o._vertex_array;
+
+        o._particles_count = 0;
+        o._vertex_array    = 0;
+    }
+    return *this;
+}
+
+} // namespace utils
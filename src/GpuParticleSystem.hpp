@@ -0,0 +1,55 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "glm/glm.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+#include "simulation/Particle.hpp"
+#include "simulation/collision.hpp"
+
+namespace utils {
+
+struct GpuParticleSystem_Descriptor {
+    sim::Obstacles const&          obstacles; // NOLINT(*avoid-const-or-ref-data-members)
+    std::span<sim::Particle const> particles; /// The initial particles. Their number never changes: dead particles respawn in place.
+    glm::vec2                      spawn_half_size{1.f, 1.f}; /// Particles respawn in the [-spawn_half_size, +spawn_half_size] rectangle
+};
+
+/// Simulates the particles entirely on the GPU, with compute shaders: they move, bounce on the obstacles and respawn when they die without ever coming back to the CPU.
+/// The bounces follow the same rules as sim::update_particles(). Gravity is not simulated.
+/// The disks are drawn straight from the storage buffer the compute shader writes in.
+/// Requires OpenGL 4.3 (see is_supported()), TransformFeedbackParticleSystem does the same with OpenGL 4.1. Mesa's llvmpipe implements it, so it also runs on machines without a GPU, e.g. with LIBGL_ALWAYS_SOFTWARE=1.
+class GpuParticleSystem {
+public:
+    explicit GpuParticleSystem(GpuParticleSystem_Descriptor const&);
+    ~GpuParticleSystem();
+    GpuParticleSystem(GpuParticleSystem const&)                    = delete; // You cannot copy
+    auto operator=(GpuParticleSystem const&) -> GpuParticleSystem& = delete; // a GpuParticleSystem. But you can move it, using std::move(my_particles)
+    GpuParticleSystem(GpuParticleSystem&&) noexcept;
+    auto operator=(GpuParticleSystem&&) noexcept -> GpuParticleSystem&;
+
+    static auto is_supported() -> bool;
+
+    /// Ages the particles by dt, moves them and makes them bounce on the obstacles. Respawns those that died.
+    void update(float dt);
+    /// Draws the particles between their positions before and after the last update(), as in ParticleSystem::interpolated_position()
+    void draw(float interpolation_factor, float radius) const;
+
+    auto size() const -> size_t { return _particles_count; }
+    /// Copies the particles back from the GPU. This waits for the GPU, so only use it to check or debug the simulation.
+    auto read_particles() const -> std::vector<sim::Particle>;
+
+private:
+    size_t            _particles_count;
+    glm::vec2         _spawn_half_size;
+    uint32_t          _steps_count{0}; /// Seeds the random numbers of each step differently
+    gl::StorageBuffer _particles;
+    gl::StorageBuffer _segments;
+    gl::StorageBuffer _circles;
+    int               _segments_count;
+    int               _circles_count;
+    gl::ComputeShader _update_shader;
+    gl::Shader        _render_shader;
+    GLuint            _vertex_array{}; /// Reads the particles from the storage buffer, as per-instance attributes
+};
+
+} // namespace utils
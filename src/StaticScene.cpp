@@ -0,0 +1,147 @@
+#include "StaticScene.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+#include "frame_uniforms.hpp"
+
+namespace utils {
+
+static auto make_static_scene_shader() -> gl::Shader
+{
+    auto shader = gl::Shader{
+        gl::Shader_Descriptor{
+            .vertex   = gl::ShaderSource::Code{std::string{"#version 410\n"} + frame_uniforms_glsl + R"GLSL(
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec4 in_color;
+
+out vec4 v_color;
+
+void main()
+{
+    gl_Position = vec4(in_position * vec2(u_frame.inverse_aspect_ratio, 1.), 0., 1.);
+    v_color = in_color;
+}
+)GLSL"},
+            .fragment = gl::ShaderSource::Code({R"GLSL(
+#version 410
+
+out vec4 out_color;
+
+in vec4 v_color;
+
+void main()
+{
+    out_color = v_color;
+}
+)GLSL"}),
+            .compile_asynchronously = true,
+        }
+    };
+    use_frame_uniforms(shader);
+    return shader;
+}
+
+namespace {
+
+/// A Position2D followed by a ColorRGBA8: 12 bytes instead of 24 with a float color
+struct Vertex {
+    glm::vec2   position;
+    glm::u8vec4 color;
+};
+
+/// Accumulates triangles
+class Triangles {
+public:
+    void add_vertex(glm::vec2 const& position, glm::vec4 const& color)
+    {
+        vertices.push_back({position, glm::u8vec4{glm::round(glm::clamp(color, 0.f, 1.f) * 255.f)}});
+    }
+    auto vertices_count() const -> uint32_t { return static_cast<uint32_t>(vertices.size()); }
+
+    /// Same as the quad of utils::draw_line()
+    void add_segment(sim::Segment const& segment, float thickness, glm::vec4 const& color)
+    {
+        glm::vec2 const dir    = glm::normalize(segment.end - segment.start);
+        glm::vec2 const offset = glm::vec2{-dir.y, dir.x} * thickness * 0.5f;
+
+        uint32_t const first = vertices_count();
+        add_vertex(segment.start - offset, color);
+        add_vertex(segment.end - offset, color);
+        add_vertex(segment.end + offset, color);
+        add_vertex(segment.start + offset, color);
+        indices.insert(indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+    }
+
+    /// A fan of `sides_count` triangles around the center
+    void add_circle(sim::Circle const& circle, uint32_t sides_count, glm::vec4 const& color)
+    {
+        uint32_t const center = vertices_count();
+        add_vertex(circle.center, color);
+        for (uint32_t i = 0; i < sides_count; ++i)
+        {
+            float const angle = 2.f * std::numbers::pi_v<float> * static_cast<float>(i) / static_cast<float>(sides_count);
+            add_vertex(circle.center + circle.radius * glm::vec2{std::cos(angle), std::sin(angle)}, color);
+            indices.insert(indices.end(), {center, center + 1 + i, center + 1 + (i + 1) % sides_count});
+        }
+    }
+
+    std::vector<Vertex>   vertices{};
+    std::vector<uint32_t> indices{};
+};
+
+} // namespace
+
+/// The fewest sides that keep the polygon within half a pixel of the circle
+static auto circle_sides_count(float radius, int framebuffer_height_in_pixels) -> uint32_t
+{
+    float const max_error = 1.f / static_cast<float>(std::max(framebuffer_height_in_pixels, 1)); // The framebuffer is 2 units high
+    if (radius <= max_error)
+        return 8;
+    float const sides_count = std::ceil(std::numbers::pi_v<float> / std::acos(1.f - max_error / radius));
+    return static_cast<uint32_t>(std::clamp(sides_count, 8.f, 256.f));
+}
+
+StaticScene::StaticScene(StaticScene_Descriptor const& desc)
+    : _obstacles{desc.obstacles}
+    , _segments_thickness{desc.segments_thickness}
+    , _segments_color{desc.segments_color}
+    , _circles_color{desc.circles_color}
+    , _framebuffer_height_in_pixels{gl::framebuffer_height_in_pixels()}
+    , _mesh{make_mesh()}
+    , _shader{make_static_scene_shader()}
+{
+}
+
+auto StaticScene::make_mesh() const -> gl::Mesh
+{
+    auto triangles = Triangles{};
+    for (auto const& segment : _obstacles.segments)
+        triangles.add_segment(segment, _segments_thickness, _segments_color);
+    for (auto const& circle : _obstacles.circles)
+        triangles.add_circle(circle, circle_sides_count(circle.radius, _framebuffer_height_in_pixels), _circles_color);
+
+    return gl::Mesh{gl::Mesh_Descriptor{
+        .vertex_buffers = {
+            gl::VertexBuffer_Descriptor{
+                .layout = {gl::VertexAttribute::Position2D(0), gl::VertexAttribute::ColorRGBA8(1)},
+                .data   = triangles.vertices,
+            },
+        },
+        .index_buffer = triangles.indices,
+    }};
+}
+
+void StaticScene::draw()
+{
+    if (gl::framebuffer_height_in_pixels() != _framebuffer_height_in_pixels)
+    {
+        _framebuffer_height_in_pixels = gl::framebuffer_height_in_pixels();
+        _mesh                         = make_mesh();
+    }
+
+    _shader.bind();
+    _mesh.draw();
+}
+
+} // namespace utils
@@ -0,0 +1,38 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+#include "simulation/collision.hpp"
+
+namespace utils {
+
+struct StaticScene_Descriptor {
+    sim::Obstacles const& obstacles;                                // NOLINT(*avoid-const-or-ref-data-members)
+    float                 segments_thickness{0.01f};
+    glm::vec4             segments_color{1.f, 1.f, 1.f, 1.f};
+    glm::vec4             circles_color{1.f, 0.f, 0.f, 0.3f};
+};
+
+/// Draws the obstacles, which never move, with a single draw call.
+/// The segments and circles are tessellated into triangles once, in a gl::Mesh that stays on the GPU.
+/// The circles are tessellated finely enough to look round at the current framebuffer size, so the mesh is only rebuilt when that size changes.
+/// The shader reads the aspect ratio from the FrameUniforms, which must be bound to frame_uniforms_binding.
+class StaticScene {
+public:
+    explicit StaticScene(StaticScene_Descriptor const&);
+
+    void draw();
+
+private:
+    auto make_mesh() const -> gl::Mesh;
+
+private:
+    sim::Obstacles _obstacles;
+    float          _segments_thickness;
+    glm::vec4      _segments_color;
+    glm::vec4      _circles_color;
+    int            _framebuffer_height_in_pixels; /// The one _mesh was tessellated for
+    gl::Mesh       _mesh;
+    gl::Shader     _shader;
+};
+
+} // namespace utils
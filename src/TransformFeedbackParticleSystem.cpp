@@ -0,0 +1,215 @@
+#include "TransformFeedbackParticleSystem.hpp"
+#include <algorithm>
+#include <format>
+#include "gpu_particles.hpp"
+
+namespace utils {
+
+/// The particle, read from the vertex attributes, and the outputs that are captured into the other buffer
+static constexpr char const* attributes_glsl = R"GLSL(
+layout(location = 0) in vec4  in_color_start;
+layout(location = 1) in vec4  in_color_end;
+layout(location = 2) in vec2  in_position;
+layout(location = 3) in vec2  in_velocity;
+layout(location = 4) in vec2  in_previous_position;
+layout(location = 5) in float in_age;
+layout(location = 6) in float in_lifetime;
+
+out vec4  out_color_start;
+out vec4  out_color_end;
+out vec2  out_position;
+out vec2  out_velocity;
+out vec2  out_previous_position;
+out float out_age;
+out float out_lifetime;
+)GLSL";
+
+/// Runs update_particle() on the particle of the current vertex
+static constexpr char const* update_main_glsl = R"GLSL(
+void main()
+{
+    Particle p = update_particle(
+        Particle(in_color_start, in_color_end, in_position, in_velocity, in_previous_position, in_age, in_lifetime),
+        uint(gl_VertexID)
+    );
+    out_color_start       = p.color_start;
+    out_color_end         = p.color_end;
+    out_position          = p.position;
+    out_velocity          = p.velocity;
+    out_previous_position = p.previous_position;
+    out_age               = p.age;
+    out_lifetime          = p.lifetime;
+}
+)GLSL";
+
+/// The binding point of the buffer that holds the obstacles
+static constexpr GLuint obstacles_binding = 1;
+
+/// Arrays can't be empty, so empty arrays still get one (unused) element
+static auto segments_array_size(sim::Obstacles const& obstacles) -> size_t
+{
+    return std::max<size_t>(obstacles.segments.size(), 1);
+}
+static auto circles_array_size(sim::Obstacles const& obstacles) -> size_t
+{
+    return std::max<size_t>(obstacles.circles.size(), 1);
+}
+
+/// There are no storage buffers before OpenGL 4.3, so the obstacles are arrays in a uniform block
+static auto obstacles_glsl(sim::Obstacles const& obstacles) -> std::string
+{
+    return std::format(
+        "layout(std140) uniform Obstacles {{\n    vec4 segments[{}];\n    vec4 circles[{}];\n}};\n",
+        segments_array_size(obstacles), circles_array_size(obstacles)
+    );
+}
+
+/// Laid out as the Obstacles block: the segments (start in xy and end in zw), then the circles (center in xy and radius in z)
+static auto make_obstacles_buffer(sim::Obstacles const& obstacles) -> gl::UniformBuffer<glm::vec4>
+{
+    auto segments = std::vector<glm::vec4>{};
+    for (auto const& segment : obstacles.segments)
+        segments.emplace_back(segment.start, segment.end);
+    auto circles = std::vector<glm::vec4>{};
+    for (auto const& circle : obstacles.circles)
+        circles.emplace_back(circle.center, circle.radius, 0.f);
+
+    auto buffer = gl::UniformBuffer<glm::vec4>{{.count = segments_array_size(obstacles) + circles_array_size(obstacles)}};
+    buffer.upload(segments, 0);
+    buffer.upload(circles, segments_array_size(obstacles));
+    return buffer;
+}
+
+static auto make_update_shader(sim::Obstacles const& obstacles) -> gl::TransformFeedbackShader
+{
+    auto shader = gl::TransformFeedbackShader{{
+        .vertex           = gl::ShaderSource::Code{particle_shaders::header(410) + particle_shaders::particle_struct + attributes_glsl + obstacles_glsl(obstacles) + particle_shaders::update_particle + update_main_glsl},
+        // In the order of the members of GpuParticle, so that the captured particles have the same layout as the ones we read
+        .captured_outputs = {"out_color_start", "out_color_end", "out_position", "out_velocity", "out_previous_position", "out_age", "out_lifetime"},
+    }};
+
+    shader.bind_uniform_block("Obstacles", obstacles_binding);
+    shader.bind();
+    shader.set_uniform("u_segments_count", static_cast<int>(obstacles.segments.size()));
+    shader.set_uniform("u_circles_count", static_cast<int>(obstacles.circles.size()));
+    return shader;
+}
+
+TransformFeedbackParticleSystem::TransformFeedbackParticleSystem(GpuParticleSystem_Descriptor const& desc)
+    : _particles_count{desc.particles.size()}
+    , _spawn_half_size{desc.spawn_half_size}
+    , _obstacles{make_obstacles_buffer(desc.obstacles)}
+    , _update_shader{make_update_shader(desc.obstacles)}
+    , _render_shader{particle_shaders::make_render_shader()}
+{
+    auto gpu_particles = std::vector<GpuParticle>{};
+    gpu_particles.reserve(desc.particles.size());
+    for (auto const& particle : desc.particles)
+        gpu_particles.push_back(to_gpu_particle(particle));
+    auto const size_in_bytes = static_cast<GLsizeiptr>(std::max<size_t>(gpu_particles.size(), 1) * sizeof(GpuParticle));
+
+    glGenBuffers(2, _buffers.data());
+    glGenVertexArrays(2, _update_vertex_arrays.data());
+    glGenVertexArrays(2, _render_vertex_arrays.data());
+    for (size_t i = 0; i < 2; ++i)
+    {
+        gl::state::bind_buffer(GL_ARRAY_BUFFER, _buffers[i]);
+        // Only the first buffer starts with the particles, the second one is written by the first update
+        glBufferData(GL_ARRAY_BUFFER, size_in_bytes, i == 0 && !gpu_particles.empty() ? gpu_particles.data() : nullptr, GL_DYNAMIC_COPY);
+
+        gl::state::bind_vertex_array(_update_vertex_arrays[i]);
+        particle_shaders::set_attributes(_buffers[i], 0);
+        gl::state::bind_vertex_array(_render_vertex_arrays[i]);
+        particle_shaders::set_attributes(_buffers[i], 1);
+    }
+}
+
+void TransformFeedbackParticleSystem::update(float dt)
+{
+    _obstacles.bind(obstacles_binding);
+    _update_shader.bind();
+    _update_shader.set_uniform("u_dt", dt);
+    _update_shader.set_uniform("u_seed", static_cast<int>(_steps_count++));
+    _update_shader.set_uniform("u_spawn_half_size", _spawn_half_size);
+
+    size_t const next = 1 - _current;
+    gl::state::bind_vertex_array(_update_vertex_arrays[_current]);
+    _update_shader.run(static_cast<GLsizei>(_particles_count), _buffers[next]);
+    _current = next;
+}
+
+void TransformFeedbackParticleSystem::draw(float interpolation_factor, float radius) const
+{
+    gl::state::bind_vertex_array(_render_vertex_arrays[_current]);
+    particle_shaders::draw(_render_shader, _particles_count, interpolation_factor, radius);
+}
+
+auto TransformFeedbackParticleSystem::read_particles() const -> std::vector<sim::Particle>
+{
+    auto gpu_particles = std::vector<GpuParticle>(_particles_count);
+    gl::state::bind_buffer(GL_COPY_READ_BUFFER, _buffers[_current]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(gpu_particles.size() * sizeof(GpuParticle)), gpu_particles.data());
+
+    auto particles = std::vector<sim::Particle>{};
+    particles.reserve(gpu_particles.size());
+    for (auto const& particle : gpu_particles)
+        particles.push_back(to_particle(particle));
+    return particles;
+}
+
+void TransformFeedbackParticleSystem::destroy()
+{
+    gl::state::delete_vertex_arrays(_render_vertex_arrays);
+    gl::state::delete_vertex_arrays(_update_vertex_arrays);
+    gl::state::delete_buffers(_buffers);
+}
+
+TransformFeedbackParticleSystem::~TransformFeedbackParticleSystem()
+{
+    destroy();
+}
+
+TransformFeedbackParticleSystem::TransformFeedbackParticleSystem(TransformFeedbackParticleSystem&& o) noexcept
+    : _particles_count{o._particles_count}
+    , _spawn_half_size{o._spawn_half_size}
+    , _steps_count{o._steps_count}
+    , _buffers{o._buffers}
+    , _update_vertex_arrays{o._update_vertex_arrays}
+    , _render_vertex_arrays{o._render_vertex_arrays}
+    , _current{o._current}
+    , _obstacles{std::move(o._obstacles)}
+    , _update_shader{std::move(o._update_shader)}
+    , _render_shader{std::move(o._render_shader)}
+{
+    o._particles_count      = 0;
+    o._buffers              = {};
+    o._update_vertex_arrays = {};
+    o._render_vertex_arrays = {};
+}
+
+auto TransformFeedbackParticleSystem::operator=(TransformFeedbackParticleSystem&& o) noexcept -> TransformFeedbackParticleSystem&
+{
+    if (this != &o)
+    {
+        destroy();
+
+        _particles_count      = o._particles_count;
+        _spawn_half_size      = o._spawn_half_size;
+        _steps_count          = o._steps_count;
+        _buffers              = o._buffers;
+        _update_vertex_arrays = o._update_vertex_arrays;
+        _render_vertex_arrays = o._render_vertex_arrays;
+        _current              = o._current;
+        _obstacles            = std::move(o._obstacles);
+        _update_shader        = std::move(o._update_shader);
+        _render_shader        = std::move(o._render_shader);
+
+        o._particles_count      = 0;
+        o._buffers              = {};
+        o._update_vertex_arrays = {};
+        o._render_vertex_arrays = {};
+    }
+    return *this;
+}
+
+} // namespace utils
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <vector>
+#include "GpuParticleSystem.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+
+namespace utils {
+
+/// Same as GpuParticleSystem, but only requires OpenGL 4.1 (e.g. MacOS) since it doesn't use compute shaders.
+/// The particles are updated by a vertex shader, whose outputs are captured (transform feedback) into a second buffer.
+/// Each update reads one buffer and writes the other, then they swap roles. The particles never come back to the CPU.
+/// The obstacles are read from a uniform buffer, since storage buffers aren't available either.
+class TransformFeedbackParticleSystem {
+public:
+    explicit TransformFeedbackParticleSystem(GpuParticleSystem_Descriptor const&);
+    ~TransformFeedbackParticleSystem();
+    TransformFeedbackParticleSystem(TransformFeedbackParticleSystem const&)                    = delete; // You cannot copy
+    auto operator=(TransformFeedbackParticleSystem const&) -> TransformFeedbackParticleSystem& = delete; // a TransformFeedbackParticleSystem. But you can move it, using std::move(my_particles)
+    TransformFeedbackParticleSystem(TransformFeedbackParticleSystem&&) noexcept;
+    auto operator=(TransformFeedbackParticleSystem&&) noexcept -> TransformFeedbackParticleSystem&;
+
+    /// Ages the particles by dt, moves them and makes them bounce on the obstacles. Respawns those that died.
+    void update(float dt);
+    /// Draws the particles between their positions before and after the last update(), as in ParticleSystem::interpolated_position()
+    void draw(float interpolation_factor, float radius) const;
+
+    auto size() const -> size_t { return _particles_count; }
+    /// Copies the particles back from the GPU. This waits for the GPU, so only use it to check or debug the simulation.
+    auto read_particles() const -> std::vector<sim::Particle>;
+
+private:
+    void destroy();
+
+private:
+    size_t                       _particles_count;
+    glm::vec2                    _spawn_half_size;
+    uint32_t                     _steps_count{0};         /// Seeds the random numbers of each step differently
+    std::array<GLuint, 2>        _buffers{};              /// Each update reads the current one and writes the other
+    std::array<GLuint, 2>        _update_vertex_arrays{}; /// Read _buffers[i] with one vertex per particle
+    std::array<GLuint, 2>        _render_vertex_arrays{}; /// Read _buffers[i] with one instance per particle
+    size_t                       _current{0};             /// Index of the buffer that holds the latest state of the particles
+    gl::UniformBuffer<glm::vec4> _obstacles;              /// The segments, then the circles, as the Obstacles block of _update_shader
+    gl::TransformFeedbackShader  _update_shader;
+    gl::Shader                   _render_shader;
+};
+
+} // namespace utils
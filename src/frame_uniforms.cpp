@@ -0,0 +1,27 @@
+#include "frame_uniforms.hpp"
+
+namespace utils {
+
+auto current_frame_uniforms() -> FrameUniforms
+{
+    return FrameUniforms{
+        .inverse_aspect_ratio         = 1.f / gl::framebuffer_aspect_ratio(),
+        .framebuffer_height_in_pixels = static_cast<float>(gl::framebuffer_height_in_pixels()),
+        .time_in_seconds              = gl::time_in_seconds(),
+    };
+}
+
+char const* const frame_uniforms_glsl = R"GLSL(
+layout(std140) uniform Frame {
+    float inverse_aspect_ratio;
+    float framebuffer_height_in_pixels;
+    float time_in_seconds;
+} u_frame;
+)GLSL";
+
+void use_frame_uniforms(gl::Shader const& shader)
+{
+    shader.bind_uniform_block("Frame", frame_uniforms_binding);
+}
+
+} // namespace utils
@@ -0,0 +1,26 @@
+#pragma once
+#include "opengl-framework/opengl-framework.hpp"
+
+namespace utils {
+
+/// The uniforms that are the same for all the draws of a frame. They are uploaded once per frame into a gl::UniformBuffer, that all the shaders read.
+/// Must match the std140 layout of the Frame block, see frame_uniforms_glsl.
+struct FrameUniforms {
+    float inverse_aspect_ratio;
+    float framebuffer_height_in_pixels;
+    float time_in_seconds;
+    float padding{}; // std140 pads blocks to 16 bytes
+};
+
+/// The binding point of the buffer that holds the FrameUniforms
+inline constexpr GLuint frame_uniforms_binding = 0;
+
+/// The uniforms of the current frame. Call it once per frame, it queries the window.
+auto current_frame_uniforms() -> FrameUniforms;
+
+/// The declaration of the Frame block, to paste right after the #version line. It makes the members of FrameUniforms available as `u_frame.inverse_aspect_ratio` etc.
+extern char const* const frame_uniforms_glsl;
+/// Makes the Frame block of the shader read the buffer bound to frame_uniforms_binding
+void use_frame_uniforms(gl::Shader const&);
+
+} // namespace utils
@@ -0,0 +1,300 @@
+#include "gpu_particles.hpp"
+#include <cstddef>
+#include <format>
+#include "frame_uniforms.hpp"
+#include "simulation/update.hpp"
+
+namespace utils {
+
+auto to_gpu_particle(sim::Particle const& particle) -> GpuParticle
+{
+    return GpuParticle{
+        .color_start       = particle.color_start,
+        .color_end         = particle.color_end,
+        .position          = particle.position,
+        .velocity          = particle.velocity,
+        .previous_position = particle.position,
+        .age               = particle.age,
+        .lifetime          = particle.lifetime,
+    };
+}
+
+auto to_particle(GpuParticle const& particle) -> sim::Particle
+{
+    return sim::Particle{
+        .position    = particle.position,
+        .velocity    = particle.velocity,
+        .age         = particle.age,
+        .lifetime    = particle.lifetime,
+        .color_start = particle.color_start,
+        .color_end   = particle.color_end,
+    };
+}
+
+namespace particle_shaders {
+
+auto header(int glsl_version) -> std::string
+{
+    return std::format(
+        "#version {}\nconst int max_contacts_per_step = {};\nconst float contact_offset = {:e};\n",
+        glsl_version, sim::max_contacts_per_step, sim::contact_offset
+    );
+}
+
+char const* const particle_struct = R"GLSL(
+struct Particle {
+    vec4  color_start;
+    vec4  color_end;
+    vec2  position;
+    vec2  velocity;
+    vec2  previous_position;
+    float age;
+    float lifetime;
+};
+)GLSL";
+
+/// A GLSL port of sim::closest_hit() and sim::update_particles(), operation for operation
+char const* const update_particle = R"GLSL(
+uniform int   u_segments_count;
+uniform int   u_circles_count;
+uniform float u_dt;
+uniform int   u_seed;
+uniform vec2  u_spawn_half_size;
+
+const uint no_obstacle = 0xFFFFFFFFu;
+
+struct Hit {
+    vec2  point;
+    vec2  normal;
+    float distance_squared;
+    uint  obstacle_id;
+};
+
+bool segment_intersect(vec2 p1, vec2 p2, vec2 q1, vec2 q2, out vec2 intersection)
+{
+    vec2 r = p2 - p1;
+    vec2 s = q2 - q1;
+
+    float rxs = r.x * s.y - r.y * s.x;
+    if (rxs == 0.)
+        return false;
+
+    float t = ((q1 - p1).x * s.y - (q1 - p1).y * s.x) / rxs;
+    float u = ((q1 - p1).x * r.y - (q1 - p1).y * r.x) / rxs;
+    if (t >= 0. && t <= 1. && u >= 0. && u <= 1.)
+    {
+        intersection = p1 + t * r;
+        return true;
+    }
+    return false;
+}
+
+bool segment_circle_intersect(vec2 p1, vec2 p2, vec2 circle_center, float circle_radius, out vec2 intersection)
+{
+    vec2 d = p2 - p1;
+    vec2 f = p1 - circle_center;
+
+    float a = dot(d, d);
+    float b = 2. * dot(f, d);
+    float c = dot(f, f) - circle_radius * circle_radius;
+
+    float discriminant = b * b - 4. * a * c;
+    if (discriminant < 0.)
+        return false;
+    discriminant = sqrt(discriminant);
+
+    float t1 = (-b - discriminant) / (2. * a);
+    float t2 = (-b + discriminant) / (2. * a);
+    float t;
+    if (t1 >= 0. && t1 <= 1.)
+        t = t1;
+    else if (t2 >= 0. && t2 <= 1.)
+        t = t2;
+    else
+        return false;
+
+    intersection = p1 + t * d;
+    return true;
+}
+
+bool is_closer(Hit candidate, bool has_current, Hit current)
+{
+    return !has_current
+           || candidate.distance_squared < current.distance_squared
+           || (candidate.distance_squared == current.distance_squared && candidate.obstacle_id < current.obstacle_id);
+}
+
+bool closest_hit(vec2 p1, vec2 p2, uint ignored_obstacle_id, out Hit closest)
+{
+    bool found = false;
+    for (int i = 0; i < u_segments_count; ++i)
+    {
+        vec2 point;
+        if (uint(i) == ignored_obstacle_id || !segment_intersect(p1, p2, segments[i].xy, segments[i].zw, point))
+            continue;
+        vec2 dir = normalize(segments[i].zw - segments[i].xy);
+        Hit  hit = Hit(point, vec2(-dir.y, dir.x), dot(point - p1, point - p1), uint(i));
+        if (is_closer(hit, found, closest))
+        {
+            closest = hit;
+            found   = true;
+        }
+    }
+    for (int i = 0; i < u_circles_count; ++i)
+    {
+        vec2 point;
+        uint id = uint(u_segments_count + i);
+        if (id == ignored_obstacle_id || !segment_circle_intersect(p1, p2, circles[i].xy, circles[i].z, point))
+            continue;
+        Hit hit = Hit(point, normalize(point - circles[i].xy), dot(point - p1, point - p1), id);
+        if (is_closer(hit, found, closest))
+        {
+            closest = hit;
+            found   = true;
+        }
+    }
+    return found;
+}
+
+void move_and_bounce(inout vec2 position, inout vec2 velocity, vec2 new_pos)
+{
+    vec2 leg_start = position;
+    vec2 leg_end   = new_pos;
+    Hit  hit;
+    bool has_hit = closest_hit(leg_start, leg_end, no_obstacle, hit);
+    for (int contact = 0; contact < max_contacts_per_step && has_hit; ++contact)
+    {
+        vec2 normal_towards_particle = dot(velocity, hit.normal) < 0. ? hit.normal : -hit.normal;
+        velocity                     = velocity - 2. * dot(velocity, hit.normal) * hit.normal;
+
+        float distance_behind = length(leg_end - hit.point);
+        leg_start             = hit.point + normal_towards_particle * contact_offset;
+        leg_end               = leg_start + normalize(velocity) * distance_behind;
+        has_hit               = closest_hit(leg_start, leg_end, hit.obstacle_id, hit);
+    }
+    // Out of contacts while the last leg still crosses an obstacle: stop at the last contact rather than going through it
+    position = has_hit ? leg_start : leg_end;
+}
+
+// PCG hash, see "Hash Functions for GPU Rendering" (Jarzynski and Olano, 2020)
+uint hash(uint x)
+{
+    uint state = x * 747796405u + 2891336453u;
+    uint word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float rand(inout uint state, float min, float max)
+{
+    state = hash(state);
+    return mix(min, max, float(state >> 8u) / 16777216.);
+}
+
+// Same distributions as the default sim::Emitter_Descriptor, over the spawn rectangle
+Particle random_particle(uint index)
+{
+    uint state = hash(index ^ hash(uint(u_seed)));
+
+    Particle p;
+    p.position          = vec2(rand(state, -u_spawn_half_size.x, u_spawn_half_size.x), rand(state, -u_spawn_half_size.y, u_spawn_half_size.y));
+    p.previous_position = p.position;
+    float angle         = rand(state, 0., 6.2831853);
+    p.velocity          = rand(state, 0.1, 0.2) * vec2(cos(angle), sin(angle));
+    p.age               = 0.;
+    p.lifetime          = rand(state, 5., 10.);
+    p.color_start       = vec4(rand(state, 0.5, 1.), rand(state, 0.5, 1.), rand(state, 0.5, 1.), 1.);
+    p.color_end         = vec4(rand(state, 0.5, 1.), rand(state, 0.5, 1.), rand(state, 0.5, 1.), 1.);
+    return p;
+}
+
+Particle update_particle(Particle p, uint index)
+{
+    p.age += u_dt;
+    p.previous_position = p.position;
+    move_and_bounce(p.position, p.velocity, p.position + p.velocity * u_dt);
+    if (p.age >= p.lifetime)
+        p = random_particle(index);
+    return p;
+}
+)GLSL";
+
+auto make_render_shader() -> gl::Shader
+{
+    auto shader = gl::Shader{{
+        .vertex   = gl::ShaderSource::Code{std::string{"#version 410\n"} + frame_uniforms_glsl + R"GLSL(
+layout(location = 0) in vec4  in_color_start;
+layout(location = 1) in vec4  in_color_end;
+layout(location = 2) in vec2  in_position;
+layout(location = 4) in vec2  in_previous_position;
+layout(location = 5) in float in_age;
+layout(location = 6) in float in_lifetime;
+
+uniform float u_interpolation_factor;
+uniform float u_radius;
+
+out vec2 v_uv;
+out vec4 v_color;
+
+void main()
+{
+    // The corners of the square the disk is cut out of, drawn as a triangle strip
+    v_uv          = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 center   = mix(in_previous_position, in_position, u_interpolation_factor);
+    vec2 position = center + u_radius * (2. * v_uv - 1.);
+
+    gl_Position = vec4(position * vec2(u_frame.inverse_aspect_ratio, 1.), 0., 1.);
+    v_color     = mix(in_color_start, in_color_end, in_age / in_lifetime);
+}
+)GLSL"},
+        .fragment = gl::ShaderSource::Code{R"GLSL(
+#version 410
+
+out vec4 out_color;
+
+in vec2 v_uv;
+in vec4 v_color;
+
+void main()
+{
+    vec2 dir = v_uv - vec2(0.5);
+    if (dot(dir, dir) > 0.25)
+        discard;
+    out_color = v_color;
+}
+)GLSL"},
+        .compile_asynchronously = true,
+    }};
+    use_frame_uniforms(shader);
+    return shader;
+}
+
+static void set_attribute(GLuint location, GLint size, size_t offset, GLuint divisor)
+{
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), reinterpret_cast<void*>(offset)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+    glVertexAttribDivisor(location, divisor);
+}
+
+void set_attributes(GLuint buffer, GLuint divisor)
+{
+    gl::state::bind_buffer(GL_ARRAY_BUFFER, buffer);
+    set_attribute(0, 4, offsetof(GpuParticle, color_start), divisor);
+    set_attribute(1, 4, offsetof(GpuParticle, color_end), divisor);
+    set_attribute(2, 2, offsetof(GpuParticle, position), divisor);
+    set_attribute(3, 2, offsetof(GpuParticle, velocity), divisor);
+    set_attribute(4, 2, offsetof(GpuParticle, previous_position), divisor);
+    set_attribute(5, 1, offsetof(GpuParticle, age), divisor);
+    set_attribute(6, 1, offsetof(GpuParticle, lifetime), divisor);
+}
+
+void draw(gl::Shader const& render_shader, size_t particles_count, float interpolation_factor, float radius)
+{
+    render_shader.bind();
+    render_shader.set_uniform("u_interpolation_factor", interpolation_factor);
+    render_shader.set_uniform("u_radius", radius);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(particles_count));
+}
+
+} // namespace particle_shaders
+
+} // namespace utils
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include "glm/glm.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+#include "simulation/Particle.hpp"
+
+namespace utils {
+
+/// The layout of a particle in the buffers of the GPU simulations. The shaders declare it as the Particle struct (std430).
+/// Transform feedback writes the outputs of the update shader in this order too.
+struct GpuParticle {
+    glm::vec4 color_start;
+    glm::vec4 color_end;
+    glm::vec2 position;
+    glm::vec2 velocity;
+    glm::vec2 previous_position;
+    float     age;
+    float     lifetime;
+};
+static_assert(sizeof(GpuParticle) == 64, "Must match the std430 layout of the Particle struct in the shaders");
+
+auto to_gpu_particle(sim::Particle const&) -> GpuParticle;
+auto to_particle(GpuParticle const&) -> sim::Particle;
+
+/// The GLSL shared by the GPU simulations
+namespace particle_shaders {
+
+/// The #version line, followed by the constants the shaders share with the CPU simulation
+auto header(int glsl_version) -> std::string;
+/// The Particle struct
+extern char const* const particle_struct;
+/// `Particle update_particle(Particle, uint index)`, a port of sim::update_particles() that also respawns the dead particles.
+/// Expects the `segments` and `circles` arrays of vec4 (start in xy and end in zw; center in xy and radius in z) to be declared before it.
+extern char const* const update_particle;
+
+/// Draws the particles from their per-instance attributes, see set_attributes(). Reads the aspect ratio from the FrameUniforms.
+auto make_render_shader() -> gl::Shader;
+/// Plugs a buffer of GpuParticles into the bound vertex array, each member at the location the shaders expect:
+/// color_start 0, color_end 1, position 2, velocity 3, previous_position 4, age 5, lifetime 6
+void set_attributes(GLuint buffer, GLuint divisor);
+/// Binds the render shader and draws the particles of the bound vertex array
+void draw(gl::Shader const& render_shader, size_t particles_count, float interpolation_factor, float radius);
+
+} // namespace particle_shaders
+
+} // namespace utils
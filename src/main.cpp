@@ -1,251 +1,146 @@
 #include "opengl-framework/opengl-framework.hpp"
-#include "utils.hpp"
+#include "DiskBatch.hpp"
+#include "StaticScene.hpp"
+#include "frame_uniforms.hpp"
+#include "GpuParticleSystem.hpp"
+#include "TransformFeedbackParticleSystem.hpp"
+#include "simulation/BarnesHut.hpp"
+#include "simulation/ColliderBVH.hpp"
+#include "simulation/Emitter.hpp"
+#include "simulation/FixedTimestep.hpp"
+#include "simulation/JobSystem.hpp"
+#include "simulation/ParticleSystem.hpp"
+#include "simulation/collision.hpp"
+#include "simulation/scene.hpp"
+#include "simulation/update.hpp"
 #include <vector>
+#include <algorithm>
 #include <array>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <variant>
 #include <glm/glm.hpp>
 
-struct Particle {
-    glm::vec2 position;
-    glm::vec2 velocity;
-    float mass;
-    float age = 0.0f;
-    float lifetime = 0.0f;
-    glm::vec4 color_start;
-    glm::vec4 color_end;
-
-    Particle() {
-        position = glm::vec2{
-            utils::rand(-gl::window_aspect_ratio(), +gl::window_aspect_ratio()),
-            utils::rand(-1.0f, 1.0f)
-        };
-
-        float angle = utils::rand(0.0f, 360.0f);
-        float speed = utils::rand(0.1f, 0.2f);
-
-        velocity = glm::vec2{
-            std::cos(angle) * speed,
-            std::sin(angle) * speed
-        };
-
-        mass = utils::rand(0.0f, 2.0f);
-        lifetime = utils::rand(5.0f, 10.0f);
-
-        color_start = glm::vec4
-        {
-            utils::rand(0.5f, 1.0f),
-            utils::rand(0.5f, 1.0f),
-            utils::rand(0.5f, 1.0f),
-            1.0f
-        };
-
-        color_end = glm::vec4
-        {
-            utils::rand(0.5f, 1.0f),
-            utils::rand(0.5f, 1.0f),
-            utils::rand(0.5f, 1.0f),
-            1.0f
-        };
-    }
-};
-
-float bounce(float x) {
-    return std::abs(std::sin(10.0f * 3.14f * x));
-}
-
-float easeInOutPower(float t, float power) {
-    if (t < 0.5f)
-        return 0.5f * std::pow(2.0f * t, power);
-    else
-        return 1.0f - 0.5f * std::pow(2.0f * (1.0f - t), power);
-}
-
-bool segment_intersect(const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& q1,
-    const glm::vec2& q2, glm::vec2& intersection)
-{
-    glm::vec2 r = p2 - p1;
-    glm::vec2 s = q2 - q1;
-
-    float rxs = r.x * s.y - r.y * s.x;
-    float qpxr = (q1 - p1).x * r.y - (q1 - p1).y * r.x;
-
-    if (rxs == 0.0f)
-    return false;
-
-    float t = ((q1 - p1).x * s.y - (q1 - p1).y * s.x) / rxs;
-    float u = ((q1 - p1).x * r.y - (q1 - p1).y * r.x) / rxs;
-
-    if (t >= 0 && t <= 1 && u >= 0 && u <= 1) {
-        intersection = p1 + t * r;
-        return true;
-    }
-
-    return false;
-}
-
-bool segment_circle_intersect(
-    const glm::vec2& p1,
-    const glm::vec2& p2,
-    const glm::vec2& circle_center,
-    float circle_radius,
-    glm::vec2& intersection)
+int main(int argc, char** argv)
 {
-    glm::vec2 d = p2 - p1;
-    glm::vec2 f = p1 - circle_center;
-
-    float a = glm::dot(d, d);
-    float b = 2.0f * glm::dot(f, d);
-    float c = glm::dot(f, f) - circle_radius * circle_radius;
-
-    float discriminant = b * b - 4 * a * c;
-
-    if (discriminant < 0.0f) {
-        return false;
-    }
-
-    discriminant = std::sqrt(discriminant);
-
-    float t1 = (-b - discriminant) / (2 * a);
-    float t2 = (-b + discriminant) / (2 * a);
-
-    bool hit = false;
-    float t = 0.0f;
-
-    if (t1 >= 0.0f && t1 <= 1.0f) {
-        t = t1;
-        hit = true;
-    } else if (t2 >= 0.0f && t2 <= 1.0f) {
-        t = t2;
-        hit = true;
-    }
-
-    if (hit) {
-        intersection = p1 + t * d;
-    }
-
-    return hit;
-}
+    auto const has_flag = [&](std::string_view flag) {
+        return std::find(argv, argv + argc, flag) != argv + argc;
+    };
+    // --gravity makes the particles attract each other
+    bool const gravity_enabled = has_flag("--gravity");
+    // --gpu simulates the particles on the GPU instead (without gravity), with compute shaders when available and transform feedback otherwise. Run with LIBGL_ALWAYS_SOFTWARE=1 to use Mesa's llvmpipe on machines without a GPU.
+    bool const gpu_enabled = has_flag("--gpu");
+    // --transform-feedback simulates the particles on the GPU with transform feedback, even when compute shaders are available
+    bool const transform_feedback_enabled = has_flag("--transform-feedback");
+    // --gl-stats prints, every second, how many state changes the last frame sent to OpenGL, and how many redundant ones gl::state skipped
+    bool const gl_stats_enabled = has_flag("--gl-stats");
+    bool const gpu_simulation   = gpu_enabled || transform_feedback_enabled;
 
-int main()
-{
     gl::init("Particules!");
     gl::maximize_window();
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    gl::state::set_blending(true);
+    gl::state::set_blend_function(GL_SRC_ALPHA, GL_ONE);
     
-    std::array<glm::vec2, 9> star_points = {
-    glm::vec2{ 0.0f,  0.5f},
-    glm::vec2{ 0.4755f, 0.1545f},
-    glm::vec2{ 0.2939f, -0.4045f},
-    glm::vec2{-0.2939f, -0.4045f},
-    glm::vec2{-0.4755f, 0.1545f}, 
-    {-gl::window_aspect_ratio(), -1.0f}, 
-    { gl::window_aspect_ratio(), -1.0f},
-    { gl::window_aspect_ratio(),  1.0f}, 
-    {-gl::window_aspect_ratio(),  1.0f}  
-    };
-
-    std::array<std::pair<int, int>, 9> star_segments = {
-        std::make_pair(0, 2),
-        std::make_pair(2, 4),
-        std::make_pair(4, 1),
-        std::make_pair(1, 3),
-        std::make_pair(3, 0),
-
-        std::make_pair(5, 6),
-        std::make_pair(6, 7),
-        std::make_pair(7, 8),
-        std::make_pair(8, 5)
-    };
-
-    std::vector<std::pair<glm::vec2, float>> circle_obstacles =
+    sim::Obstacles const obstacles = sim::star_obstacles(gl::window_aspect_ratio());
+    sim::ColliderBVH const colliders{obstacles};
+
+    sim::JobSystem jobs{};
+
+    size_t const particles_count = 100;
+    // Only used when the particles are simulated on the CPU
+    sim::ParticleSystem particles{gpu_simulation ? 0 : particles_count};
+
+    // Spawns particles all over the window, at the rate they die, to keep the population steady
+    sim::Emitter emitter{{
+        .shape        = sim::EmitterShape::Rectangle{.half_size = {gl::window_aspect_ratio(), 1.f}},
+        .spawn_rate   = static_cast<float>(particles_count) / 7.5f,
+        .min_lifetime = 5.f,
+        .max_lifetime = 10.f,
+    }};
+    if (!gpu_simulation)
+        emitter.burst(particles, particles_count);
+
+    std::optional<std::variant<utils::GpuParticleSystem, utils::TransformFeedbackParticleSystem>> gpu_particles{};
+    if (gpu_simulation)
     {
-        { glm::vec2(-0.5f, 0.0f), 0.15f },
-        { glm::vec2( 0.5f, 0.4f), 0.1f },
-        { glm::vec2( 0.0f, -0.5f), 0.2f }
-    };
-
-    std::vector<Particle> particles;
-    for (int i = 0; i < 100; ++i)
-    {
-        particles.emplace_back();
+        auto initial_particles = std::vector<sim::Particle>{};
+        for (size_t i = 0; i < particles_count; ++i)
+            initial_particles.push_back(sim::random_particle(gl::window_aspect_ratio()));
+        auto const desc = utils::GpuParticleSystem_Descriptor{
+            .obstacles       = obstacles,
+            .particles       = initial_particles,
+            .spawn_half_size = {gl::window_aspect_ratio(), 1.f},
+        };
+        if (utils::GpuParticleSystem::is_supported() && !transform_feedback_enabled)
+            gpu_particles.emplace(std::in_place_type<utils::GpuParticleSystem>, desc);
+        else
+            gpu_particles.emplace(std::in_place_type<utils::TransformFeedbackParticleSystem>, desc);
     }
 
-    while (gl::window_is_open())
-    {
-        glClearColor(0.f, 0.f, 0.f, 1.f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        for (auto const& seg : star_segments)
-        {
-            glm::vec2 start = star_points[seg.first];
-            glm::vec2 end = star_points[seg.second];
-            utils::draw_line(start, end, 0.01f, glm::vec4(1.f, 1.f, 1.f, 1.f));
-        }
-
-        float dt = gl::delta_time_in_seconds();
-
-        for (auto& p : particles)
-        {
-            p.age += dt;
-            glm::vec2 old_pos = p.position;
-            glm::vec2 new_pos = p.position + p.velocity * dt;
-            glm::vec2 hit_point;
-            bool hit = false;
-
-            for (auto const& seg : star_segments)
-            {
-                glm::vec2 start = star_points[seg.first];
-                glm::vec2 end = star_points[seg.second];
+    sim::BarnesHutTree gravity_tree{};
+    sim::Gravity_Descriptor const gravity{
+        .gravitational_constant = 0.01f / static_cast<float>(particles_count),
+    };
 
-                if (segment_intersect(old_pos, new_pos, start, end, hit_point))
-                {
-                    hit = true;
-                    glm::vec2 wall_dir = glm::normalize(end - start);
-                    glm::vec2 wall_normal = glm::vec2(-wall_dir.y, wall_dir.x);
+    // The physics runs at 120 Hz whatever the frame rate, and rendering interpolates between the last two steps
+    sim::FixedTimestep timestep{{.step_duration = 1.f / 120.f}};
 
-                    p.velocity = p.velocity - 2.0f * glm::dot(p.velocity, wall_normal) * wall_normal;
+    // Uploaded once per frame, and read by all the shaders
+    gl::UniformBuffer<utils::FrameUniforms> frame_uniforms{};
+    frame_uniforms.bind(utils::frame_uniforms_binding);
 
-                    float distance_behind = glm::length(new_pos - hit_point);
-                    p.position = hit_point + glm::normalize(p.velocity) * distance_behind;
+    // The obstacles are tessellated once, and drawn with a single draw call
+    utils::StaticScene obstacles_scene{{.obstacles = obstacles}};
 
-                    break;
-                }
-            }
+    // All the particles of a frame are drawn at once. They are small, so they are drawn as points.
+    utils::DiskBatch particle_disks{{.primitive = utils::DiskPrimitive::Point}};
+    if (!gpu_simulation)
+        particle_disks.reserve(particles_count);
 
-            if (!hit) {
-    for (auto const& circle : circle_obstacles)
+    float next_stats_time = 0.f;
+    while (gl::window_is_open())
     {
-        glm::vec2 hit_point;
-        if (segment_circle_intersect(old_pos, new_pos, circle.first, circle.second, hit_point))
+        if (gl_stats_enabled && gl::time_in_seconds() >= next_stats_time)
         {
-            hit = true;
-
-            glm::vec2 normal = glm::normalize(hit_point - circle.first);
-            p.velocity = p.velocity - 2.0f * glm::dot(p.velocity, normal) * normal;
-
-            float distance_behind = glm::length(new_pos - hit_point);
-            p.position = hit_point + glm::normalize(p.velocity) * distance_behind;
-
-            break;
+            auto const stats = gl::state::last_frame_stats();
+            std::cout << "GL state changes per frame: " << stats.calls_made << " made, " << stats.calls_saved << " skipped\n";
+            next_stats_time = gl::time_in_seconds() + 1.f;
         }
-    }
-}
 
-            for (auto const& circle : circle_obstacles)
-            {
-                utils::draw_disk(circle.first, circle.second, glm::vec4(1, 0, 0, 0.3f));
-            }
+        glClearColor(0.f, 0.f, 0.f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
 
-            if (!hit)
+        frame_uniforms.upload(utils::current_frame_uniforms());
+        obstacles_scene.draw();
+
+        int const steps_count = timestep.advance(gl::delta_time_in_seconds());
+        float const dt = timestep.step_duration();
+        for (int step = 0; step < steps_count; ++step)
+        {
+            if (gpu_particles)
             {
-                p.position = new_pos;
+                std::visit([&](auto& gpu) { gpu.update(dt); }, *gpu_particles);
+                continue;
             }
+            if (gravity_enabled)
+                sim::apply_gravity(particles, gravity_tree, gravity, dt, jobs);
+            sim::update_particles(particles, colliders, dt, jobs);
+            particles.kill_expired();
+            emitter.update(particles, dt);
+        }
+        float const alpha = timestep.interpolation_factor();
 
-            // particles do not die
-            glm::vec4 color = p.color_start;
+        for (size_t i = 0; !gpu_particles && i < particles.size(); ++i)
+        {
+            float t = particles.age()[i] / particles.lifetime()[i];
+            glm::vec4 color = glm::mix(particles.color_start()[i], particles.color_end()[i], t);
             float radius = 0.05f;
 
-            utils::draw_disk(p.position, radius, color);
+            particle_disks.add(particles.interpolated_position(i, alpha), radius, color);
         }
+        particle_disks.draw();
+        if (gpu_particles)
+            std::visit([&](auto const& gpu) { gpu.draw(alpha, 0.05f); }, *gpu_particles);
     }
 }
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include "BarnesHut.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace sim {
+
+/// Inserts a 0 between each of the 16 lowest bits of x
+static auto spread_bits(uint32_t x) -> uint32_t
+{
+    x &= 0x0000FFFFu;
+    x = (x | (x << 8)) & 0x00FF00FFu;
+    x = (x | (x << 4)) & 0x0F0F0F0Fu;
+    x = (x | (x << 2)) & 0x33333333u;
+    x = (x | (x << 1)) & 0x55555555u;
+    return x;
+}
+
+/// Interleaves the bits of x and y. Sorting points by Morton code sorts them by quadrant, then by sub-quadrant, etc.
+static auto morton_code(uint32_t x, uint32_t y) -> uint32_t
+{
+    return spread_bits(x) | (spread_bits(y) << 1);
+}
+
+/// The bits of the code that tell in which child of a node of the given level the point lies
+static auto quadrant(uint32_t code, uint32_t level) -> uint32_t
+{
+    return (code >> (32 - 2 * (level + 1))) & 3u;
+}
+
+void BarnesHutTree::compute_center_of_mass(std::vector<Node>& nodes, uint32_t index)
+{
+    auto  weighted_sum = glm::vec2{0.f};
+    auto  sum          = glm::vec2{0.f};
+    float mass         = 0.f;
+    float count        = 0.f;
+    for (uint32_t const child : nodes[index].children)
+    {
+        if (child == no_child)
+            continue;
+        weighted_sum += nodes[child].mass * nodes[child].center_of_mass;
+        sum += nodes[child].center_of_mass;
+        mass += nodes[child].mass;
+        count += 1.f;
+    }
+    nodes[index].mass           = mass;
+    nodes[index].center_of_mass = mass > 0.f ? weighted_sum / mass : sum / std::max(count, 1.f);
+}
+
+auto BarnesHutTree::build_subtree(std::vector<Node>& nodes, uint32_t begin, uint32_t end, uint32_t level, float size) const -> uint32_t
+{
+    auto const index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node{.size = size});
+
+    if (end - begin <= leaf_size || level == max_level)
+    {
+        auto  weighted_sum = glm::vec2{0.f};
+        auto  sum          = glm::vec2{0.f};
+        float mass         = 0.f;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            auto const position = glm::vec2{_sorted_x[i], _sorted_y[i]};
+            weighted_sum += _sorted_mass[i] * position;
+            sum += position;
+            mass += _sorted_mass[i];
+        }
+        auto& node           = nodes[index];
+        node.mass            = mass;
+        node.center_of_mass  = mass > 0.f ? weighted_sum / mass : sum / static_cast<float>(end - begin);
+        node.particles_begin = begin;
+        node.particles_end   = end;
+        node.is_leaf         = true;
+        return index;
+    }
+
+    uint32_t child_begin = begin;
+    for (uint32_t q = 0; q < 4; ++q)
+    {
+        auto const child_end = static_cast<uint32_t>(
+            std::partition_point(_sorted_entries.begin() + child_begin, _sorted_entries.begin() + end, [&](Entry const& entry) {
+                return quadrant(entry.code, level) <= q;
+            })
+            - _sorted_entries.begin()
+        );
+        if (child_end != child_begin)
+        {
+            uint32_t const child    = build_subtree(nodes, child_begin, child_end, level + 1, size * 0.5f);
+            nodes[index].children[q] = child; // Must be indexed after build_subtree(), which might have reallocated nodes
+        }
+        child_begin = child_end;
+    }
+    compute_center_of_mass(nodes, index);
+    return index;
+}
+
+void BarnesHutTree::build(ParticleSystem const& particles, JobSystem& jobs)
+{
+    _nodes.clear();
+    size_t const particles_count = particles.size();
+    if (particles_count == 0)
+        return;
+    assert(particles_count < std::numeric_limits<uint32_t>::max());
+
+    auto const x    = particles.position_x();
+    auto const y    = particles.position_y();
+    auto const mass = particles.mass();
+
+    // Split the particles into a few contiguous ranges per thread, for the passes that need per-range results
+    size_t const tasks_count = std::min(particles_count, 4 * jobs.threads_count());
+    auto const   task_range  = [&](size_t task) {
+        return std::make_pair(particles_count * task / tasks_count, particles_count * (task + 1) / tasks_count);
+    };
+
+    // Bounds of the particles
+    _tasks_bounds.resize(tasks_count);
+    jobs.parallel_for(0, tasks_count, 1, [&](size_t tasks_begin, size_t tasks_end) {
+        for (size_t task = tasks_begin; task < tasks_end; ++task)
+        {
+            auto [begin, end] = task_range(task);
+            auto min          = glm::vec2{std::numeric_limits<float>::max()};
+            auto max          = glm::vec2{std::numeric_limits<float>::lowest()};
+            for (size_t i = begin; i < end; ++i)
+            {
+                min = glm::min(min, glm::vec2{x[i], y[i]});
+                max = glm::max(max, glm::vec2{x[i], y[i]});
+            }
+            _tasks_bounds[task] = {min, max};
+        }
+    });
+    auto min = glm::vec2{std::numeric_limits<float>::max()};
+    auto max = glm::vec2{std::numeric_limits<float>::lowest()};
+    for (auto const& bounds : _tasks_bounds)
+    {
+        min = glm::min(min, bounds.first);
+        max = glm::max(max, bounds.second);
+    }
+    float const root_size = std::max(max.x - min.x, max.y - min.y) * 1.0001f + 1e-6f; // Cells are square
+    float const to_grid   = 65536.f / root_size;
+
+    // Morton codes, and number of particles per task in each bucket
+    _entries.resize(particles_count);
+    _histograms.assign(tasks_count * buckets_count, 0);
+    jobs.parallel_for(0, tasks_count, 1, [&](size_t tasks_begin, size_t tasks_end) {
+        for (size_t task = tasks_begin; task < tasks_end; ++task)
+        {
+            auto [begin, end] = task_range(task);
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto const     grid = glm::min(glm::uvec2{(glm::vec2{x[i], y[i]} - min) * to_grid}, glm::uvec2{65535u});
+                uint32_t const code = morton_code(grid.x, grid.y);
+                _entries[i]         = {code, static_cast<uint32_t>(i)};
+                ++_histograms[task * buckets_count + (code >> (32 - 2 * top_levels))];
+            }
+        }
+    });
+
+    // Turn the histograms into the position where each task writes its particles of each bucket
+    uint32_t offset = 0;
+    for (uint32_t bucket = 0; bucket < buckets_count; ++bucket)
+    {
+        _buckets_begin[bucket] = offset;
+        for (size_t task = 0; task < tasks_count; ++task)
+        {
+            uint32_t const count = _histograms[task * buckets_count + bucket];
+            _histograms[task * buckets_count + bucket] = offset;
+            offset += count;
+        }
+    }
+    _buckets_begin[buckets_count] = offset;
+
+    // Scatter the particles into their bucket
+    _sorted_entries.resize(particles_count);
+    jobs.parallel_for(0, tasks_count, 1, [&](size_t tasks_begin, size_t tasks_end) {
+        for (size_t task = tasks_begin; task < tasks_end; ++task)
+        {
+            auto [begin, end] = task_range(task);
+            for (size_t i = begin; i < end; ++i)
+            {
+                uint32_t const bucket = _entries[i].code >> (32 - 2 * top_levels);
+                _sorted_entries[_histograms[task * buckets_count + bucket]++] = _entries[i];
+            }
+        }
+    });
+
+    // Sort each bucket and build its subtree
+    _sorted_x.resize(particles_count);
+    _sorted_y.resize(particles_count);
+    _sorted_mass.resize(particles_count);
+    jobs.parallel_for(0, buckets_count, 1, [&](size_t buckets_begin, size_t buckets_end) {
+        for (size_t bucket = buckets_begin; bucket < buckets_end; ++bucket)
+        {
+            uint32_t const begin = _buckets_begin[bucket];
+            uint32_t const end   = _buckets_begin[bucket + 1];
+            std::sort(_sorted_entries.begin() + begin, _sorted_entries.begin() + end, [](Entry const& a, Entry const& b) { return a.code < b.code; });
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                _sorted_x[i]    = x[_sorted_entries[i].index];
+                _sorted_y[i]    = y[_sorted_entries[i].index];
+                _sorted_mass[i] = mass[_sorted_entries[i].index];
+            }
+            _buckets_nodes[bucket].clear();
+            if (begin != end)
+                build_subtree(_buckets_nodes[bucket], begin, end, top_levels, root_size / static_cast<float>(1u << top_levels));
+        }
+    });
+
+    // Copy the subtrees after the nodes of the top levels
+    uint32_t constexpr top_nodes_count = (buckets_count - 1) / 3; // 1 + 4 + 16 + ... up to the level just above the buckets
+    auto buckets_offset                = std::array<uint32_t, buckets_count + 1>{};
+    buckets_offset[0]                  = top_nodes_count;
+    for (uint32_t bucket = 0; bucket < buckets_count; ++bucket)
+        buckets_offset[bucket + 1] = buckets_offset[bucket] + static_cast<uint32_t>(_buckets_nodes[bucket].size());
+    _nodes.resize(buckets_offset[buckets_count]);
+    jobs.parallel_for(0, buckets_count, 1, [&](size_t buckets_begin, size_t buckets_end) {
+        for (size_t bucket = buckets_begin; bucket < buckets_end; ++bucket)
+        {
+            for (size_t i = 0; i < _buckets_nodes[bucket].size(); ++i)
+            {
+                auto node = _buckets_nodes[bucket][i];
+                for (auto& child : node.children)
+                {
+                    if (child != no_child)
+                        child += buckets_offset[bucket];
+                }
+                _nodes[buckets_offset[bucket] + i] = node;
+            }
+        }
+    });
+
+    // Link the top levels, from the level just above the buckets up to the root
+    uint32_t level_begin = top_nodes_count; // Index of the first node of the level below
+    uint32_t level_nodes = buckets_count;   // Number of nodes in the level below
+    for (uint32_t level = top_levels; level-- > 0;)
+    {
+        uint32_t const parents_count = level_nodes / 4;
+        uint32_t const parents_begin = level_begin - parents_count;
+        for (uint32_t parent = 0; parent < parents_count; ++parent)
+        {
+            auto& node = _nodes[parents_begin + parent];
+            node       = Node{.size = root_size / static_cast<float>(1u << level)};
+            for (uint32_t q = 0; q < 4; ++q)
+            {
+                uint32_t const child = 4 * parent + q;
+                if (level + 1 == top_levels)
+                {
+                    if (!_buckets_nodes[child].empty())
+                        node.children[q] = buckets_offset[child];
+                }
+                else
+                {
+                    if (!is_empty(_nodes[level_begin + child]))
+                        node.children[q] = level_begin + child;
+                }
+            }
+            compute_center_of_mass(_nodes, parents_begin + parent);
+        }
+        level_begin = parents_begin;
+        level_nodes = parents_count;
+    }
+}
+
+auto BarnesHutTree::acceleration(glm::vec2 const& position, Gravity_Descriptor const& desc) const -> glm::vec2
+{
+    assert(desc.softening > 0.f && "The softening must be positive, otherwise a particle pulls itself by 0 / 0 = NaN");
+    if (_nodes.empty())
+        return glm::vec2{0.f};
+
+    float const softening_squared     = desc.softening * desc.softening;
+    float const opening_angle_squared = desc.opening_angle * desc.opening_angle;
+
+    auto pull = [&](glm::vec2 const& other_position, float other_mass) {
+        glm::vec2 const delta            = other_position - position;
+        float const     distance_squared = glm::dot(delta, delta) + softening_squared;
+        return (other_mass / (distance_squared * std::sqrt(distance_squared))) * delta;
+    };
+
+    auto acceleration = glm::vec2{0.f};
+
+    auto     stack      = std::array<uint32_t, 4 * (max_level + 1)>{};
+    uint32_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size != 0)
+    {
+        auto const& node = _nodes[stack[--stack_size]];
+        if (node.is_leaf)
+        {
+            for (uint32_t i = node.particles_begin; i < node.particles_end; ++i)
+                acceleration += pull({_sorted_x[i], _sorted_y[i]}, _sorted_mass[i]);
+            continue;
+        }
+
+        glm::vec2 const delta = node.center_of_mass - position;
+        if (node.size * node.size < opening_angle_squared * glm::dot(delta, delta))
+        {
+            acceleration += pull(node.center_of_mass, node.mass);
+            continue;
+        }
+
+        for (uint32_t const child : node.children)
+        {
+            if (child != no_child)
+                stack[stack_size++] = child;
+        }
+    }
+
+    return desc.gravitational_constant * acceleration;
+}
+
+void apply_gravity(ParticleSystem& particles, BarnesHutTree& tree, Gravity_Descriptor const& desc, float dt, JobSystem& jobs)
+{
+    tree.build(particles, jobs);
+
+    auto const columns = particles.columns();
+    jobs.parallel_for(0, particles.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j)
+        {
+            uint32_t const  i            = tree.particle_index_in_tree_order(j);
+            glm::vec2 const acceleration = tree.acceleration({columns.position_x[i], columns.position_y[i]}, desc);
+            columns.velocity_x[i] += acceleration.x * dt;
+            columns.velocity_y[i] += acceleration.y * dt;
+        }
+    });
+}
+
+} // namespace sim
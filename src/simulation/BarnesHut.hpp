@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "JobSystem.hpp"
+#include "ParticleSystem.hpp"
+#include "glm/glm.hpp"
+
+namespace sim {
+
+struct Gravity_Descriptor {
+    float gravitational_constant{1e-4f};
+    float opening_angle{0.5f}; /// θ: a cell of size s seen from a distance d is approximated by its center of mass when s / d < θ. 0 is exact but O(N²), bigger is faster but less accurate.
+    float softening{0.01f};    /// ε: distances are computed as sqrt(d² + ε²), so that close encounters don't produce huge forces. Must be > 0, otherwise two particles at the same position would pull each other by 0 / 0.
+};
+
+/// Quadtree over the particles, where each cell knows the total mass and the center of mass of the particles it contains.
+/// The gravitational pull of a far away cell is approximated by the pull of its center of mass, which brings the computation of the forces down to O(N log N).
+///
+/// The tree is rebuilt every frame. Both the build and the traversal run in parallel on a JobSystem:
+/// particles are sorted by Morton code into the 64 cells of the 3rd level of the tree, then the subtrees of these cells are built concurrently and the 3 top levels are linked on top of them.
+class BarnesHutTree {
+public:
+    void build(ParticleSystem const&, JobSystem&);
+
+    /// Acceleration caused by the gravitational pull of all the particles of the tree, at the given position.
+    /// A particle of the tree located exactly at `position` doesn't contribute, thanks to the softening.
+    auto acceleration(glm::vec2 const& position, Gravity_Descriptor const&) const -> glm::vec2;
+
+    /// Index in the ParticleSystem of the i-th particle in the order of the tree.
+    /// Particles that are close in this order are close in space, so computing their accelerations in this order makes consecutive traversals visit the same nodes, which are then still in the cache.
+    auto particle_index_in_tree_order(size_t i) const -> uint32_t { return _sorted_entries[i].index; }
+
+private:
+    static constexpr uint32_t no_child      = 0xFFFFFFFFu;
+    static constexpr uint32_t top_levels    = 3;
+    static constexpr uint32_t buckets_count = 1u << (2 * top_levels);
+    static constexpr uint32_t max_level     = 16; /// Our 32-bit Morton codes contain 16 levels of quadrants
+    static constexpr uint32_t leaf_size     = 8;
+
+    struct Node {
+        glm::vec2               center_of_mass{};
+        float                   mass{0.f};
+        float                   size{0.f};
+        std::array<uint32_t, 4> children{no_child, no_child, no_child, no_child};
+        uint32_t                particles_begin{0}; /// Only for leaves: the range of the particles inside the leaf, in the sorted arrays
+        uint32_t                particles_end{0};
+        bool                    is_leaf{false};
+    };
+
+    struct Entry {
+        uint32_t code;
+        uint32_t index;
+    };
+
+    auto        build_subtree(std::vector<Node>& nodes, uint32_t begin, uint32_t end, uint32_t level, float size) const -> uint32_t;
+    static void compute_center_of_mass(std::vector<Node>& nodes, uint32_t index); /// The children must already have their own center of mass
+    static auto is_empty(Node const& node) -> bool { return !node.is_leaf && node.children == std::array{no_child, no_child, no_child, no_child}; }
+
+private:
+    std::vector<std::pair<glm::vec2, glm::vec2>> _tasks_bounds{};
+    std::array<uint32_t, buckets_count + 1>      _buckets_begin{};
+    std::vector<Entry>                           _entries{};
+    std::vector<Entry>                           _sorted_entries{};
+    std::vector<float>                           _sorted_x{};
+    std::vector<float>                           _sorted_y{};
+    std::vector<float>                           _sorted_mass{};
+    std::vector<uint32_t>                        _histograms{};
+    std::array<std::vector<Node>, buckets_count> _buckets_nodes{};
+    std::vector<Node>                            _nodes{}; /// The root is _nodes[0], then come the other nodes of the top levels, then the subtrees of the buckets
+};
+
+/// Accelerates each particle with the gravitational pull of all the others, using their mass.
+void apply_gravity(ParticleSystem&, BarnesHutTree&, Gravity_Descriptor const&, float dt, JobSystem&);
+
+} // namespace sim
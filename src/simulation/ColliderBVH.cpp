@@ -0,0 +1,177 @@
+#include "ColliderBVH.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace sim {
+
+ColliderBVH::ColliderBVH(Obstacles obstacles)
+    : _obstacles{std::move(obstacles)}
+{
+    auto primitives    = std::vector<Primitive>{};
+    auto add_primitive = [&](glm::vec2 min, glm::vec2 max) {
+        // Inflate the boxes a little so that the broad-phase never rejects a pair that the exact test would accept because of rounding errors
+        float const margin = 1e-5f * (1.f + std::max({std::abs(min.x), std::abs(min.y), std::abs(max.x), std::abs(max.y)}));
+        min -= margin;
+        max += margin;
+        primitives.push_back({.min = min, .max = max, .centroid = (min + max) * 0.5f, .obstacle_id = static_cast<uint32_t>(primitives.size())});
+    };
+    primitives.reserve(_obstacles.segments.size() + _obstacles.circles.size());
+    for (auto const& segment : _obstacles.segments)
+        add_primitive(glm::min(segment.start, segment.end), glm::max(segment.start, segment.end));
+    for (auto const& circle : _obstacles.circles)
+        add_primitive(circle.center - circle.radius, circle.center + circle.radius);
+    assert(primitives.size() < leaf_bit && "Too many obstacles");
+
+    if (!primitives.empty())
+        build(primitives.begin(), primitives.end(), 0);
+}
+
+/// Reorders the primitives so that the first half has the smallest centroids along the axis where they are the most spread out, and returns the middle.
+static auto split_at_median(auto begin, auto end)
+{
+    auto centroids_min = glm::vec2{std::numeric_limits<float>::max()};
+    auto centroids_max = glm::vec2{std::numeric_limits<float>::lowest()};
+    for (auto it = begin; it != end; ++it)
+    {
+        centroids_min = glm::min(centroids_min, it->centroid);
+        centroids_max = glm::max(centroids_max, it->centroid);
+    }
+    auto const extent = centroids_max - centroids_min;
+    auto const axis   = extent.x >= extent.y ? 0 : 1;
+
+    auto const middle = begin + (end - begin) / 2;
+    std::nth_element(begin, middle, end, [&](auto const& a, auto const& b) { return a.centroid[axis] < b.centroid[axis]; });
+    return middle;
+}
+
+auto ColliderBVH::build(std::vector<Primitive>::iterator begin, std::vector<Primitive>::iterator end, size_t depth) -> uint32_t
+{
+    assert(depth < max_depth);
+
+    auto const node_index = static_cast<uint32_t>(_nodes.size());
+    _nodes.push_back(Node{
+        .min_x    = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()},
+        .min_y    = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()},
+        .max_x    = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()},
+        .max_y    = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()},
+        .children = {0, 0, 0, 0},
+    }); // Empty lanes have an inverted box, so they never overlap anything
+
+    // Split the primitives into (at most) 4 groups, one per child
+    auto const count  = end - begin;
+    auto       groups = std::array<std::vector<Primitive>::iterator, 5>{};
+    if (count <= 4)
+    {
+        for (std::ptrdiff_t i = 0; i < 5; ++i)
+            groups[static_cast<size_t>(i)] = begin + std::min(i, count);
+    }
+    else
+    {
+        auto const middle = split_at_median(begin, end);
+        groups            = {begin, split_at_median(begin, middle), middle, split_at_median(middle, end), end};
+    }
+
+    for (size_t lane = 0; lane < 4; ++lane)
+    {
+        auto const group_begin = groups[lane];
+        auto const group_end   = groups[lane + 1];
+        if (group_begin == group_end)
+            continue;
+
+        auto box_min = glm::vec2{std::numeric_limits<float>::max()};
+        auto box_max = glm::vec2{std::numeric_limits<float>::lowest()};
+        for (auto it = group_begin; it != group_end; ++it)
+        {
+            box_min = glm::min(box_min, it->min);
+            box_max = glm::max(box_max, it->max);
+        }
+
+        uint32_t const child = group_end - group_begin == 1
+                                   ? (group_begin->obstacle_id | leaf_bit)
+                                   : build(group_begin, group_end, depth + 1);
+
+        auto& node          = _nodes[node_index]; // Must be fetched after build(), which might have reallocated _nodes
+        node.min_x[lane]    = box_min.x;
+        node.min_y[lane]    = box_min.y;
+        node.max_x[lane]    = box_max.x;
+        node.max_y[lane]    = box_max.y;
+        node.children[lane] = child;
+    }
+
+    return node_index;
+}
+
+auto ColliderBVH::closest_hit(glm::vec2 const& p1, glm::vec2 const& p2, uint32_t ignored_obstacle_id) const -> std::optional<Hit>
+{
+    auto closest = std::optional<Hit>{};
+    for_each_overlapping_obstacle(glm::min(p1, p2), glm::max(p1, p2), [&](uint32_t obstacle_id) {
+        if (obstacle_id == ignored_obstacle_id)
+            return;
+        auto const hit = obstacle_id < _obstacles.segments.size()
+                             ? segment_hit(p1, p2, _obstacles.segments[obstacle_id], obstacle_id)
+                             : circle_hit(p1, p2, _obstacles.circles[obstacle_id - _obstacles.segments.size()], obstacle_id);
+        if (hit && is_closer(*hit, closest))
+            closest = hit;
+    });
+    return closest;
+}
+
+void ColliderBVH::closest_hits(Paths const& paths, size_t count, std::optional<Hit>* hits) const
+{
+    assert(count <= max_batch_size);
+
+    auto box_min = glm::vec2{+std::numeric_limits<float>::infinity()};
+    auto box_max = glm::vec2{-std::numeric_limits<float>::infinity()};
+    for (size_t i = 0; i < count; ++i)
+    {
+        box_min = glm::min(box_min, glm::min(glm::vec2{paths.start_x[i], paths.start_y[i]}, glm::vec2{paths.end_x[i], paths.end_y[i]}));
+        box_max = glm::max(box_max, glm::max(glm::vec2{paths.start_x[i], paths.start_y[i]}, glm::vec2{paths.end_x[i], paths.end_y[i]}));
+    }
+
+    // Every obstacle that one of the paths hits overlaps the box around all the paths
+    auto   candidates       = std::array<uint32_t, max_batch_obstacles>{};
+    size_t candidates_count = 0;
+    bool   too_many         = false;
+    for_each_overlapping_obstacle(box_min, box_max, [&](uint32_t obstacle_id) {
+        if (candidates_count < candidates.size())
+            candidates[candidates_count++] = obstacle_id;
+        else
+            too_many = true;
+    });
+
+    if (too_many)
+    {
+        for (size_t i = 0; i < count; ++i)
+            hits[i] = closest_hit({paths.start_x[i], paths.start_y[i]}, {paths.end_x[i], paths.end_y[i]});
+        return;
+    }
+
+    std::fill(hits, hits + count, std::nullopt);
+    auto intersection_x = std::array<float, max_batch_size>{};
+    auto intersection_y = std::array<float, max_batch_size>{};
+    for (size_t c = 0; c < candidates_count; ++c)
+    {
+        uint32_t const obstacle_id = candidates[c];
+        bool const     is_segment  = obstacle_id < _obstacles.segments.size();
+        uint32_t       mask        = is_segment
+                                         ? segment_intersect_batch(paths, count, _obstacles.segments[obstacle_id], intersection_x.data(), intersection_y.data())
+                                         : segment_circle_intersect_batch(paths, count, _obstacles.circles[obstacle_id - _obstacles.segments.size()], intersection_x.data(), intersection_y.data());
+        while (mask != 0)
+        {
+            auto const      i     = static_cast<size_t>(std::countr_zero(mask));
+            glm::vec2 const p1    = {paths.start_x[i], paths.start_y[i]};
+            glm::vec2 const point = {intersection_x[i], intersection_y[i]};
+            auto const      hit   = is_segment
+                                        ? make_segment_hit(p1, point, _obstacles.segments[obstacle_id], obstacle_id)
+                                        : make_circle_hit(p1, point, _obstacles.circles[obstacle_id - _obstacles.segments.size()], obstacle_id);
+            if (is_closer(hit, hits[i]))
+                hits[i] = hit;
+            mask &= mask - 1;
+        }
+    }
+}
+
+} // namespace sim
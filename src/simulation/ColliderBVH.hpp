@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "collision.hpp"
+#include "collision_batch.hpp"
+#include "glm/glm.hpp"
+
+namespace sim {
+
+/// Bounding volume hierarchy over static obstacles, so that a particle only runs the exact collision tests against the obstacles near its path.
+/// Each node stores the bounding boxes of its 4 children side by side (one array per coordinate), so they are all tested at once by a loop the compiler can vectorize.
+/// Built once; rebuild it if the obstacles change.
+class ColliderBVH {
+public:
+    ColliderBVH() = default;
+    explicit ColliderBVH(Obstacles obstacles);
+
+    auto obstacles() const -> Obstacles const& { return _obstacles; }
+
+    /// Returns the hit closest to p1 along the path [p1, p2], ignoring `ignored_obstacle_id`. Same result as sim::closest_hit(p1, p2, obstacles(), ignored_obstacle_id).
+    auto closest_hit(glm::vec2 const& p1, glm::vec2 const& p2, uint32_t ignored_obstacle_id = no_obstacle) const -> std::optional<Hit>;
+
+    /// Sets `hits[i]` to closest_hit() of the i-th path, for the first `count` (at most max_batch_size) paths.
+    /// Each obstacle near the paths is tested against all of them at once with the SIMD batch kernels, so this is faster when the paths are close to each other.
+    /// When they are spread over too many obstacles, this falls back to testing each path on its own.
+    void closest_hits(Paths const&, size_t count, std::optional<Hit>* hits) const;
+
+    /// Calls `fn(obstacle_id)` for each obstacle whose bounding box overlaps the [box_min, box_max] box. See Hit::obstacle_id.
+    template<typename Fn>
+    void for_each_overlapping_obstacle(glm::vec2 const& box_min, glm::vec2 const& box_max, Fn&& fn) const
+    {
+        if (_nodes.empty())
+            return;
+
+        auto     stack      = std::array<uint32_t, max_depth * 3 + 1>{};
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size != 0)
+        {
+            auto const& node = _nodes[stack[--stack_size]];
+
+            std::array<bool, 4> overlaps{};
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+                overlaps[lane] = (node.min_x[lane] <= box_max.x) & (node.max_x[lane] >= box_min.x)
+                                 & (node.min_y[lane] <= box_max.y) & (node.max_y[lane] >= box_min.y);
+            }
+
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+                if (!overlaps[lane])
+                    continue;
+                uint32_t const child = node.children[lane];
+                if (child & leaf_bit)
+                    fn(child & ~leaf_bit);
+                else
+                    stack[stack_size++] = child;
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t leaf_bit            = 0x80000000u;
+    static constexpr size_t   max_depth           = 32;
+    static constexpr size_t   max_batch_obstacles = 32; /// Above that, closest_hits() tests the paths one by one
+
+    struct Node {
+        std::array<float, 4>    min_x;
+        std::array<float, 4>    min_y;
+        std::array<float, 4>    max_x;
+        std::array<float, 4>    max_y;
+        std::array<uint32_t, 4> children; /// Either the index of a child node, or an obstacle id with the leaf_bit set
+    };
+
+    struct Primitive {
+        glm::vec2 min;
+        glm::vec2 max;
+        glm::vec2 centroid;
+        uint32_t  obstacle_id;
+    };
+
+    auto build(std::vector<Primitive>::iterator begin, std::vector<Primitive>::iterator end, size_t depth) -> uint32_t;
+
+private:
+    Obstacles         _obstacles{};
+    std::vector<Node> _nodes{}; /// The root is _nodes[0]
+};
+
+} // namespace sim
@@ -0,0 +1,68 @@
+#include "Emitter.hpp"
+#include <cmath>
+#include "random.hpp"
+
+namespace sim {
+
+static auto random_position(EmitterShape::Point const& shape) -> glm::vec2
+{
+    return shape.position;
+}
+
+static auto random_position(EmitterShape::Disk const& shape) -> glm::vec2
+{
+    float const angle  = rand(0.f, 6.2831853f);
+    float const radius = shape.radius * std::sqrt(rand(0.f, 1.f)); // sqrt makes the distribution uniform over the area of the disk
+    return shape.center + radius * glm::vec2{std::cos(angle), std::sin(angle)};
+}
+
+static auto random_position(EmitterShape::Rectangle const& shape) -> glm::vec2
+{
+    return shape.center + glm::vec2{
+        rand(-shape.half_size.x, +shape.half_size.x),
+        rand(-shape.half_size.y, +shape.half_size.y),
+    };
+}
+
+static auto random_position(EmitterShape::Ring const& shape) -> glm::vec2
+{
+    float const angle = rand(0.f, 6.2831853f);
+    return shape.center + shape.radius * glm::vec2{std::cos(angle), std::sin(angle)};
+}
+
+auto Emitter::make_particle() const -> Particle
+{
+    auto p = Particle{};
+
+    p.position = std::visit([](auto&& shape) { return random_position(shape); }, _desc.shape);
+
+    float const angle = rand(_desc.min_angle, _desc.max_angle);
+    float const speed = rand(_desc.min_speed, _desc.max_speed);
+    p.velocity        = speed * glm::vec2{std::cos(angle), std::sin(angle)};
+
+    p.mass     = rand(_desc.min_mass, _desc.max_mass);
+    p.lifetime = rand(_desc.min_lifetime, _desc.max_lifetime);
+
+    p.color_start = glm::vec4{rand(0.5f, 1.0f), rand(0.5f, 1.0f), rand(0.5f, 1.0f), 1.0f};
+    p.color_end   = glm::vec4{rand(0.5f, 1.0f), rand(0.5f, 1.0f), rand(0.5f, 1.0f), 1.0f};
+
+    return p;
+}
+
+auto Emitter::burst(ParticleSystem& particles, size_t count) const -> size_t
+{
+    size_t spawned = 0;
+    while (spawned < count && particles.spawn(make_particle()))
+        ++spawned;
+    return spawned;
+}
+
+auto Emitter::update(ParticleSystem& particles, float dt) -> size_t
+{
+    _particles_to_spawn += _desc.spawn_rate * dt;
+    auto const count = static_cast<size_t>(_particles_to_spawn);
+    _particles_to_spawn -= static_cast<float>(count);
+    return burst(particles, count);
+}
+
+} // namespace sim
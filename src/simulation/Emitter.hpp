@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <variant>
+#include "ParticleSystem.hpp"
+#include "glm/glm.hpp"
+
+namespace sim {
+
+namespace EmitterShape {
+struct Point {
+    glm::vec2 position{};
+};
+struct Disk {
+    glm::vec2 center{};
+    float     radius{};
+};
+struct Rectangle {
+    glm::vec2 center{};
+    glm::vec2 half_size{};
+};
+/// Spawns particles on the outline of a circle
+struct Ring {
+    glm::vec2 center{};
+    float     radius{};
+};
+} // namespace EmitterShape
+
+using AnyEmitterShape = std::variant<
+    EmitterShape::Point,
+    EmitterShape::Disk,
+    EmitterShape::Rectangle,
+    EmitterShape::Ring>;
+
+struct Emitter_Descriptor {
+    AnyEmitterShape shape{EmitterShape::Point{}};
+    float           spawn_rate{10.f}; /// In particles per second
+    /// Particles are shot in a random direction between these two angles, in radians
+    float           min_angle{0.f};
+    float           max_angle{6.2831853f};
+    float           min_speed{0.1f};
+    float           max_speed{0.2f};
+    float           min_mass{0.f};
+    float           max_mass{2.f};
+    float           min_lifetime{5.f};
+    float           max_lifetime{10.f};
+};
+
+/// Spawns particles into a ParticleSystem, either continuously at `spawn_rate` or all at once with burst().
+/// When the pool is full, the particles that don't fit are simply not spawned.
+class Emitter {
+public:
+    explicit Emitter(Emitter_Descriptor const& desc)
+        : _desc{desc}
+    {}
+
+    /// Spawns the particles that are due after `dt` seconds of emission. Returns the number of particles actually spawned.
+    auto update(ParticleSystem&, float dt) -> size_t;
+    /// Spawns `count` particles right now. Returns the number of particles actually spawned.
+    auto burst(ParticleSystem&, size_t count) const -> size_t;
+
+    auto descriptor() -> Emitter_Descriptor& { return _desc; }
+    auto descriptor() const -> Emitter_Descriptor const& { return _desc; }
+
+private:
+    auto make_particle() const -> Particle;
+
+private:
+    Emitter_Descriptor _desc;
+    float              _particles_to_spawn{0.f}; /// Fractional part of the particles due, carried over to the next update() so that low spawn rates still spawn something
+};
+
+} // namespace sim
@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+namespace sim {
+
+struct FixedTimestep_Descriptor {
+    float step_duration{1.f / 120.f}; /// In seconds
+    int   max_steps_per_frame{8};     /// When a frame takes too long, the simulation slows down instead of trying to catch up with more and more steps
+};
+
+/// Decouples the simulation rate from the frame rate: each frame adds its duration to an accumulator, and the simulation advances by as many fixed steps as fit in it.
+/// The time left in the accumulator tells how far we are between the last two simulated states, which rendering uses to interpolate them.
+class FixedTimestep {
+public:
+    explicit FixedTimestep(FixedTimestep_Descriptor const& desc = {})
+        : _desc{desc}
+    {}
+
+    /// Accumulates the duration of the frame, and returns the number of steps to simulate for it.
+    auto advance(float frame_duration) -> int
+    {
+        _accumulator += std::max(frame_duration, 0.f);
+        int steps = static_cast<int>(std::floor(_accumulator / _desc.step_duration));
+        if (steps > _desc.max_steps_per_frame)
+        {
+            steps        = _desc.max_steps_per_frame;
+            _accumulator = static_cast<float>(steps) * _desc.step_duration; // Drop the time we can't catch up with
+        }
+        _accumulator -= static_cast<float>(steps) * _desc.step_duration;
+        return steps;
+    }
+
+    auto step_duration() const -> float { return _desc.step_duration; }
+
+    /// In [0, 1): where the current frame lies between the second to last and the last simulated states.
+    auto interpolation_factor() const -> float { return std::clamp(_accumulator / _desc.step_duration, 0.f, 1.f); }
+
+private:
+    FixedTimestep_Descriptor _desc;
+    float                    _accumulator{0.f};
+};
+
+} // namespace sim
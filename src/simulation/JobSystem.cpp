@@ -0,0 +1,192 @@
+#include "JobSystem.hpp"
+#include <algorithm>
+#include <tuple>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace sim {
+
+static void pin_current_thread_to_core(size_t core)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % CPU_SETSIZE, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (core % 64));
+#else
+    std::ignore = core;
+#endif
+}
+
+static auto default_threads_count() -> size_t
+{
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+JobSystem::JobSystem(JobSystem_Descriptor const& desc)
+    : _queues(desc.threads_count == 0 ? default_threads_count() : desc.threads_count)
+{
+    for (size_t i = 1; i < _queues.size(); ++i)
+    {
+        _workers.emplace_back([this, i, pin = desc.pin_threads]() {
+            if (pin)
+                pin_current_thread_to_core(i);
+            worker_loop(i);
+        });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock{_mutex};
+        _stop = true;
+    }
+    _wake_up.notify_all();
+    for (auto& worker : _workers)
+        worker.join();
+}
+
+void JobSystem::run_parallel_for(size_t begin, size_t end, size_t grain_size, void (*fn)(void*, size_t, size_t), void* fn_context)
+{
+    grain_size = std::max<size_t>(grain_size, 1);
+    if (end <= begin)
+        return;
+    if (_workers.empty() || end - begin <= grain_size)
+    {
+        fn(fn_context, begin, end);
+        return;
+    }
+
+    _job = Job{
+        .fn         = fn,
+        .fn_context = fn_context,
+        .grain_size = grain_size,
+    };
+    _remaining_elements.store(end - begin, std::memory_order_release);
+
+    // Give each thread an equal share to start with. Stealing will then balance the load.
+    size_t const threads_count = std::min(_queues.size(), (end - begin + grain_size - 1) / grain_size);
+    size_t const share         = (end - begin) / threads_count;
+    for (size_t i = 0; i < threads_count; ++i)
+    {
+        size_t const range_begin = begin + i * share;
+        size_t const range_end   = i + 1 == threads_count ? end : range_begin + share;
+        push(i, {range_begin, range_end});
+    }
+
+    {
+        std::lock_guard lock{_mutex};
+        ++_generation;
+    }
+    _wake_up.notify_all();
+
+    work_until_job_is_done(0);
+}
+
+void JobSystem::worker_loop(size_t worker_index)
+{
+    uint64_t seen_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock{_mutex};
+            _wake_up.wait(lock, [&]() { return _stop || _generation != seen_generation; });
+            if (_stop)
+                return;
+            seen_generation = _generation;
+        }
+        work_until_job_is_done(worker_index);
+    }
+}
+
+void JobSystem::work_until_job_is_done(size_t worker_index)
+{
+    while (_remaining_elements.load(std::memory_order_acquire) != 0)
+    {
+        auto range = pop(worker_index);
+        if (!range)
+            range = steal(worker_index);
+        if (range)
+            process(*range, worker_index);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::process(Range range, size_t worker_index)
+{
+    while (range.begin < range.end)
+    {
+        size_t const size = range.end - range.begin;
+        // Lazy splitting: only give away half of our range when our queue is empty, i.e. when there is nothing left for idle threads to steal from us
+        if (size >= 2 * _job.grain_size && _queues[worker_index].size.load(std::memory_order_relaxed) == 0)
+        {
+            size_t const middle = range.begin + size / 2;
+            if (push(worker_index, {middle, range.end}))
+            {
+                range.end = middle;
+                continue;
+            }
+        }
+
+        size_t const chunk_end = std::min(range.begin + _job.grain_size, range.end);
+        _job.fn(_job.fn_context, range.begin, chunk_end);
+        _remaining_elements.fetch_sub(chunk_end - range.begin, std::memory_order_acq_rel);
+        range.begin = chunk_end;
+    }
+}
+
+auto JobSystem::push(size_t worker_index, Range range) -> bool
+{
+    auto&           queue = _queues[worker_index];
+    std::lock_guard lock{queue.mutex};
+    size_t const    size = queue.size.load(std::memory_order_relaxed);
+    if (size == queue.ranges.size())
+        return false;
+    queue.ranges[(queue.first + size) % queue.ranges.size()] = range;
+    queue.size.store(size + 1, std::memory_order_relaxed);
+    return true;
+}
+
+auto JobSystem::pop(size_t worker_index) -> std::optional<Range>
+{
+    // The owner takes the most recently pushed range, which is the smallest one and the most likely to still be in its cache
+    auto& queue = _queues[worker_index];
+    if (queue.size.load(std::memory_order_relaxed) == 0)
+        return std::nullopt;
+    std::lock_guard lock{queue.mutex};
+    size_t const    size = queue.size.load(std::memory_order_relaxed);
+    if (size == 0)
+        return std::nullopt;
+    queue.size.store(size - 1, std::memory_order_relaxed);
+    return queue.ranges[(queue.first + size - 1) % queue.ranges.size()];
+}
+
+auto JobSystem::steal(size_t thief_index) -> std::optional<Range>
+{
+    // Thieves take the oldest range, which is the biggest one
+    for (size_t offset = 1; offset < _queues.size(); ++offset)
+    {
+        auto& queue = _queues[(thief_index + offset) % _queues.size()];
+        if (queue.size.load(std::memory_order_relaxed) == 0)
+            continue;
+        std::lock_guard lock{queue.mutex};
+        size_t const    size = queue.size.load(std::memory_order_relaxed);
+        if (size == 0)
+            continue;
+        auto const range = queue.ranges[queue.first];
+        queue.first      = (queue.first + 1) % queue.ranges.size();
+        queue.size.store(size - 1, std::memory_order_relaxed);
+        return range;
+    }
+    return std::nullopt;
+}
+
+} // namespace sim
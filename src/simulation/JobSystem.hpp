@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace sim {
+
+struct JobSystem_Descriptor {
+    size_t threads_count{0};   /// Including the thread that calls parallel_for(). 0 means one thread per hardware thread.
+    bool   pin_threads{false}; /// Pins the i-th worker thread on the i-th core. The thread that calls parallel_for() is left alone.
+};
+
+/// A pool of worker threads that run parallel_for() loops.
+/// Each thread owns a queue of ranges to process. Idle threads steal ranges from the others, and a thread splits its current range in two whenever its queue is empty, so that there is always something left to steal.
+/// This adapts the size of the chunks to the load: uniform loops end up with a few big chunks, while uneven loops get split finely where needed.
+class JobSystem {
+public:
+    explicit JobSystem(JobSystem_Descriptor const& = {});
+    ~JobSystem();
+    JobSystem(JobSystem const&)                    = delete;
+    auto operator=(JobSystem const&) -> JobSystem& = delete;
+    JobSystem(JobSystem&&)                         = delete;
+    auto operator=(JobSystem&&) -> JobSystem&      = delete;
+
+    auto threads_count() const -> size_t { return _workers.size() + 1; }
+
+    /// Calls `fn(range_begin, range_end)` on disjoint ranges that cover [begin, end), in parallel, and returns once all of them are done.
+    /// Ranges are never split below `grain_size` elements. `fn` must not throw.
+    /// Must not be called concurrently, nor from inside another parallel_for().
+    template<typename Fn>
+    void parallel_for(size_t begin, size_t end, size_t grain_size, Fn&& fn)
+    {
+        run_parallel_for(
+            begin, end, grain_size,
+            [](void* fn, size_t range_begin, size_t range_end) { (*static_cast<std::remove_reference_t<Fn>*>(fn))(range_begin, range_end); },
+            static_cast<void*>(&fn)
+        );
+    }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    /// Fixed capacity, so that pushing a range never allocates
+    struct alignas(64) WorkQueue {
+        std::mutex            mutex{};
+        std::array<Range, 32> ranges{};
+        size_t                first{0};
+        std::atomic<size_t>   size{0}; /// Can be read without locking, as a hint
+    };
+
+    struct Job {
+        void (*fn)(void*, size_t, size_t){};
+        void*  fn_context{};
+        size_t grain_size{};
+    };
+
+    void run_parallel_for(size_t begin, size_t end, size_t grain_size, void (*fn)(void*, size_t, size_t), void* fn_context);
+    void worker_loop(size_t worker_index);
+    void work_until_job_is_done(size_t worker_index);
+    void process(Range, size_t worker_index);
+    auto push(size_t worker_index, Range) -> bool;
+    auto pop(size_t worker_index) -> std::optional<Range>;
+    auto steal(size_t thief_index) -> std::optional<Range>;
+
+private:
+    std::vector<std::thread> _workers{};
+    std::vector<WorkQueue>   _queues;
+
+    Job                 _job{};
+    std::atomic<size_t> _remaining_elements{0};
+
+    std::mutex              _mutex{};
+    std::condition_variable _wake_up{};
+    uint64_t                _generation{0}; /// Incremented each time a new job starts
+    bool                    _stop{false};
+};
+
+} // namespace sim
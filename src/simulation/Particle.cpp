@@ -0,0 +1,44 @@
+#include "Particle.hpp"
+#include <cmath>
+#include "random.hpp"
+
+namespace sim {
+
+auto random_particle(float aspect_ratio) -> Particle
+{
+    auto p = Particle{};
+
+    p.position = glm::vec2{
+        rand(-aspect_ratio, +aspect_ratio),
+        rand(-1.0f, 1.0f)
+    };
+
+    float angle = rand(0.0f, 360.0f);
+    float speed = rand(0.1f, 0.2f);
+
+    p.velocity = glm::vec2{
+        std::cos(angle) * speed,
+        std::sin(angle) * speed
+    };
+
+    p.mass     = rand(0.0f, 2.0f);
+    p.lifetime = rand(5.0f, 10.0f);
+
+    p.color_start = glm::vec4{
+        rand(0.5f, 1.0f),
+        rand(0.5f, 1.0f),
+        rand(0.5f, 1.0f),
+        1.0f
+    };
+
+    p.color_end = glm::vec4{
+        rand(0.5f, 1.0f),
+        rand(0.5f, 1.0f),
+        rand(0.5f, 1.0f),
+        1.0f
+    };
+
+    return p;
+}
+
+} // namespace sim
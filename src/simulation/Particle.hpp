@@ -0,0 +1,21 @@
+#pragma once
+#include "glm/glm.hpp"
+
+namespace sim {
+
+/// All the attributes of a single particle.
+/// This is only used to describe a particle when spawning it, or to read it back: the simulation itself stores its particles column by column in a ParticleSystem.
+struct Particle {
+    glm::vec2 position{};
+    glm::vec2 velocity{};
+    float     mass{};
+    float     age{0.f};
+    float     lifetime{0.f};
+    glm::vec4 color_start{};
+    glm::vec4 color_end{};
+};
+
+/// Creates a particle with a random position inside the [-aspect_ratio, +aspect_ratio] x [-1, 1] rectangle, and random velocity, mass, lifetime and colors.
+auto random_particle(float aspect_ratio) -> Particle;
+
+} // namespace sim
@@ -0,0 +1,121 @@
+#include "ParticleSystem.hpp"
+
+namespace sim {
+
+static auto round_up_to_block_size(size_t n) -> size_t
+{
+    return (n + block_size - 1) / block_size * block_size;
+}
+
+ParticleSystem::ParticleSystem(size_t capacity)
+{
+    reserve(capacity);
+}
+
+void ParticleSystem::reserve(size_t capacity)
+{
+    capacity = round_up_to_block_size(capacity);
+    if (capacity <= _capacity)
+        return;
+
+    _position_x.reallocate(capacity, _size);
+    _position_y.reallocate(capacity, _size);
+    _previous_position_x.reallocate(capacity, _size);
+    _previous_position_y.reallocate(capacity, _size);
+    _velocity_x.reallocate(capacity, _size);
+    _velocity_y.reallocate(capacity, _size);
+    _mass.reallocate(capacity, _size);
+    _age.reallocate(capacity, _size);
+    _lifetime.reallocate(capacity, _size);
+    _color_start.reallocate(capacity, _size);
+    _color_end.reallocate(capacity, _size);
+    _capacity = capacity;
+}
+
+auto ParticleSystem::spawn(Particle const& p) -> bool
+{
+    if (full())
+        return false;
+
+    size_t const i          = _size++;
+    _position_x[i]          = p.position.x;
+    _position_y[i]          = p.position.y;
+    _previous_position_x[i] = p.position.x;
+    _previous_position_y[i] = p.position.y;
+    _velocity_x[i]          = p.velocity.x;
+    _velocity_y[i]          = p.velocity.y;
+    _mass[i]                = p.mass;
+    _age[i]                 = p.age;
+    _lifetime[i]            = p.lifetime;
+    _color_start[i]         = p.color_start;
+    _color_end[i]           = p.color_end;
+    return true;
+}
+
+void ParticleSystem::move_particle(size_t from, size_t to)
+{
+    _position_x[to]          = _position_x[from];
+    _position_y[to]          = _position_y[from];
+    _previous_position_x[to] = _previous_position_x[from];
+    _previous_position_y[to] = _previous_position_y[from];
+    _velocity_x[to]          = _velocity_x[from];
+    _velocity_y[to]          = _velocity_y[from];
+    _mass[to]                = _mass[from];
+    _age[to]                 = _age[from];
+    _lifetime[to]            = _lifetime[from];
+    _color_start[to]         = _color_start[from];
+    _color_end[to]           = _color_end[from];
+}
+
+auto ParticleSystem::kill_expired() -> size_t
+{
+    size_t const initial_size = _size;
+    size_t       i            = 0;
+    while (i < _size)
+    {
+        if (_age[i] >= _lifetime[i])
+        {
+            --_size;
+            if (i != _size)
+                move_particle(_size, i);
+            // Don't increment i, the particle we just moved into slot i still needs to be checked
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    return initial_size - _size;
+}
+
+auto ParticleSystem::particle(size_t i) const -> Particle
+{
+    return Particle{
+        .position    = position(i),
+        .velocity    = velocity(i),
+        .mass        = _mass[i],
+        .age         = _age[i],
+        .lifetime    = _lifetime[i],
+        .color_start = _color_start[i],
+        .color_end   = _color_end[i],
+    };
+}
+
+auto ParticleSystem::columns() -> ParticleColumns
+{
+    return ParticleColumns{
+        .position_x          = _position_x.data(),
+        .position_y          = _position_y.data(),
+        .previous_position_x = _previous_position_x.data(),
+        .previous_position_y = _previous_position_y.data(),
+        .velocity_x          = _velocity_x.data(),
+        .velocity_y          = _velocity_y.data(),
+        .mass                = _mass.data(),
+        .age                 = _age.data(),
+        .lifetime            = _lifetime.data(),
+        .color_start         = _color_start.data(),
+        .color_end           = _color_end.data(),
+    };
+}
+
+} // namespace sim
@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <span>
+#include <utility>
+#include "Particle.hpp"
+#include "glm/glm.hpp"
+
+namespace sim {
+
+/// Every column starts on its own cache line.
+inline constexpr size_t column_alignment = 64;
+/// The capacity of a ParticleSystem is always a multiple of this, so that vectorized passes can process whole blocks without a scalar tail loop.
+inline constexpr size_t block_size = 16;
+
+namespace internal {
+/// Cache-line aligned storage for a trivially copyable type.
+template<typename T>
+class AlignedColumn {
+public:
+    AlignedColumn() = default;
+    ~AlignedColumn()
+    {
+        ::operator delete(_data, std::align_val_t{column_alignment});
+    }
+    AlignedColumn(AlignedColumn const&)                    = delete; // You cannot copy
+    auto operator=(AlignedColumn const&) -> AlignedColumn& = delete; // a column. But you can move it, using std::move(my_column)
+    AlignedColumn(AlignedColumn&& o) noexcept
+        : _data{o._data}
+    {
+        o._data = nullptr;
+    }
+    auto operator=(AlignedColumn&& o) noexcept -> AlignedColumn&
+    {
+        if (&o != this)
+        {
+            ::operator delete(_data, std::align_val_t{column_alignment});
+            _data   = o._data;
+            o._data = nullptr;
+        }
+        return *this;
+    }
+
+    /// Allocates room for `new_capacity` elements, keeps the first `size_to_keep` ones and zero-initializes the others.
+    void reallocate(size_t new_capacity, size_t size_to_keep)
+    {
+        auto* const new_data = static_cast<T*>(::operator new(new_capacity * sizeof(T), std::align_val_t{column_alignment}));
+        if (_data != nullptr)
+            std::memcpy(new_data, _data, size_to_keep * sizeof(T));
+        std::memset(new_data + size_to_keep, 0, (new_capacity - size_to_keep) * sizeof(T)); // NOLINT(*pointer-arithmetic)
+        ::operator delete(_data, std::align_val_t{column_alignment});
+        _data = new_data;
+    }
+
+    auto data() -> T* { return _data; }
+    auto data() const -> T const* { return _data; }
+    auto operator[](size_t i) -> T& { return _data[i]; }
+    auto operator[](size_t i) const -> T const& { return _data[i]; }
+
+private:
+    T* _data{nullptr};
+};
+} // namespace internal
+
+/// Raw pointers to the columns of a ParticleSystem, for the hot loops.
+/// They are invalidated by anything that changes the capacity of the ParticleSystem.
+struct ParticleColumns {
+    float*     position_x;
+    float*     position_y;
+    float*     previous_position_x;
+    float*     previous_position_y;
+    float*     velocity_x;
+    float*     velocity_y;
+    float*     mass;
+    float*     age;
+    float*     lifetime;
+    glm::vec4* color_start;
+    glm::vec4* color_end;
+};
+
+/// Stores particles as a structure of arrays: each attribute lives in its own contiguous, aligned column.
+/// A pass that only needs a few attributes (e.g. position, velocity and age for the integration) only pulls those into the cache.
+///
+/// This is a fixed-capacity pool: spawn() and kill_expired() never allocate, so a running effect uses a constant amount of memory.
+/// Only reserve() can grow it.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity = 0);
+
+    /// Adds a particle if there is room left, and returns false if the pool is full.
+    auto spawn(Particle const&) -> bool;
+    /// Removes all the particles whose age has reached their lifetime, by moving the last particles into their slots.
+    /// This doesn't preserve the order of the particles. Returns the number of particles removed.
+    auto kill_expired() -> size_t;
+    void reserve(size_t capacity);
+    void clear() { _size = 0; }
+
+    auto size() const -> size_t { return _size; }
+    auto capacity() const -> size_t { return _capacity; }
+    auto empty() const -> bool { return _size == 0; }
+    auto full() const -> bool { return _size == _capacity; }
+
+    /// Gathers all the attributes of a particle. Hot loops should rather work on columns().
+    auto particle(size_t i) const -> Particle;
+
+    auto position(size_t i) const -> glm::vec2 { return {_position_x[i], _position_y[i]}; }
+    /// Position before the last update, to interpolate between the last two simulated states when rendering
+    auto previous_position(size_t i) const -> glm::vec2 { return {_previous_position_x[i], _previous_position_y[i]}; }
+    /// `alpha` = 0 gives the previous position, 1 gives the current one. See FixedTimestep::interpolation_factor().
+    auto interpolated_position(size_t i, float alpha) const -> glm::vec2 { return glm::mix(previous_position(i), position(i), alpha); }
+    auto velocity(size_t i) const -> glm::vec2 { return {_velocity_x[i], _velocity_y[i]}; }
+    void set_position(size_t i, glm::vec2 const& position)
+    {
+        _position_x[i] = position.x;
+        _position_y[i] = position.y;
+    }
+    void set_velocity(size_t i, glm::vec2 const& velocity)
+    {
+        _velocity_x[i] = velocity.x;
+        _velocity_y[i] = velocity.y;
+    }
+
+    auto columns() -> ParticleColumns;
+
+    auto position_x() const -> std::span<float const> { return {_position_x.data(), _size}; }
+    auto position_y() const -> std::span<float const> { return {_position_y.data(), _size}; }
+    auto previous_position_x() const -> std::span<float const> { return {_previous_position_x.data(), _size}; }
+    auto previous_position_y() const -> std::span<float const> { return {_previous_position_y.data(), _size}; }
+    auto velocity_x() const -> std::span<float const> { return {_velocity_x.data(), _size}; }
+    auto velocity_y() const -> std::span<float const> { return {_velocity_y.data(), _size}; }
+    auto mass() const -> std::span<float const> { return {_mass.data(), _size}; }
+    auto age() const -> std::span<float const> { return {_age.data(), _size}; }
+    auto lifetime() const -> std::span<float const> { return {_lifetime.data(), _size}; }
+    auto color_start() const -> std::span<glm::vec4 const> { return {_color_start.data(), _size}; }
+    auto color_end() const -> std::span<glm::vec4 const> { return {_color_end.data(), _size}; }
+
+    /// Calls `fn(begin, end)` on consecutive ranges of at most block_size particles covering [begin, end).
+    /// Every range but the first one starts on a block boundary, so its columns are aligned.
+    template<typename Fn>
+    void for_each_block(size_t begin, size_t end, Fn&& fn) const
+    {
+        while (begin < end)
+        {
+            size_t const block_end = std::min((begin / block_size + 1) * block_size, end);
+            fn(begin, block_end);
+            begin = block_end;
+        }
+    }
+    template<typename Fn>
+    void for_each_block(Fn&& fn) const
+    {
+        for_each_block(0, _size, std::forward<Fn>(fn));
+    }
+
+private:
+    void move_particle(size_t from, size_t to);
+
+private:
+    internal::AlignedColumn<float>     _position_x{};
+    internal::AlignedColumn<float>     _position_y{};
+    internal::AlignedColumn<float>     _previous_position_x{};
+    internal::AlignedColumn<float>     _previous_position_y{};
+    internal::AlignedColumn<float>     _velocity_x{};
+    internal::AlignedColumn<float>     _velocity_y{};
+    internal::AlignedColumn<float>     _mass{};
+    internal::AlignedColumn<float>     _age{};
+    internal::AlignedColumn<float>     _lifetime{};
+    internal::AlignedColumn<glm::vec4> _color_start{};
+    internal::AlignedColumn<glm::vec4> _color_end{};
+
+    size_t _size{0};
+    size_t _capacity{0};
+};
+
+} // namespace sim
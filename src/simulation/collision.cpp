@@ -0,0 +1,128 @@
+#include "collision.hpp"
+#include <cmath>
+
+namespace sim {
+
+auto segment_intersect(glm::vec2 const& p1, glm::vec2 const& p2, glm::vec2 const& q1, glm::vec2 const& q2, glm::vec2& intersection) -> bool
+{
+    glm::vec2 r = p2 - p1;
+    glm::vec2 s = q2 - q1;
+
+    float rxs = r.x * s.y - r.y * s.x;
+
+    if (rxs == 0.0f)
+        return false;
+
+    float t = ((q1 - p1).x * s.y - (q1 - p1).y * s.x) / rxs;
+    float u = ((q1 - p1).x * r.y - (q1 - p1).y * r.x) / rxs;
+
+    if (t >= 0 && t <= 1 && u >= 0 && u <= 1)
+    {
+        intersection = p1 + t * r;
+        return true;
+    }
+
+    return false;
+}
+
+auto segment_circle_intersect(glm::vec2 const& p1, glm::vec2 const& p2, glm::vec2 const& circle_center, float circle_radius, glm::vec2& intersection) -> bool
+{
+    glm::vec2 d = p2 - p1;
+    glm::vec2 f = p1 - circle_center;
+
+    float a = glm::dot(d, d);
+    float b = 2.0f * glm::dot(f, d);
+    float c = glm::dot(f, f) - circle_radius * circle_radius;
+
+    float discriminant = b * b - 4 * a * c;
+
+    if (discriminant < 0.0f)
+        return false;
+
+    discriminant = std::sqrt(discriminant);
+
+    float t1 = (-b - discriminant) / (2 * a);
+    float t2 = (-b + discriminant) / (2 * a);
+
+    bool  hit = false;
+    float t   = 0.0f;
+
+    if (t1 >= 0.0f && t1 <= 1.0f)
+    {
+        t   = t1;
+        hit = true;
+    }
+    else if (t2 >= 0.0f && t2 <= 1.0f)
+    {
+        t   = t2;
+        hit = true;
+    }
+
+    if (hit)
+        intersection = p1 + t * d;
+
+    return hit;
+}
+
+auto make_segment_hit(glm::vec2 const& p1, glm::vec2 const& point, Segment const& segment, uint32_t obstacle_id) -> Hit
+{
+    glm::vec2 const dir    = glm::normalize(segment.end - segment.start);
+    glm::vec2 const to_hit = point - p1;
+    return Hit{
+        .point            = point,
+        .normal           = glm::vec2{-dir.y, dir.x},
+        .distance_squared = glm::dot(to_hit, to_hit),
+        .obstacle_id      = obstacle_id,
+    };
+}
+
+auto make_circle_hit(glm::vec2 const& p1, glm::vec2 const& point, Circle const& circle, uint32_t obstacle_id) -> Hit
+{
+    glm::vec2 const to_hit = point - p1;
+    return Hit{
+        .point            = point,
+        .normal           = glm::normalize(point - circle.center),
+        .distance_squared = glm::dot(to_hit, to_hit),
+        .obstacle_id      = obstacle_id,
+    };
+}
+
+auto segment_hit(glm::vec2 const& p1, glm::vec2 const& p2, Segment const& segment, uint32_t obstacle_id) -> std::optional<Hit>
+{
+    glm::vec2 point;
+    if (!segment_intersect(p1, p2, segment.start, segment.end, point))
+        return std::nullopt;
+    return make_segment_hit(p1, point, segment, obstacle_id);
+}
+
+auto circle_hit(glm::vec2 const& p1, glm::vec2 const& p2, Circle const& circle, uint32_t obstacle_id) -> std::optional<Hit>
+{
+    glm::vec2 point;
+    if (!segment_circle_intersect(p1, p2, circle.center, circle.radius, point))
+        return std::nullopt;
+    return make_circle_hit(p1, point, circle, obstacle_id);
+}
+
+auto closest_hit(glm::vec2 const& p1, glm::vec2 const& p2, Obstacles const& obstacles, uint32_t ignored_obstacle_id) -> std::optional<Hit>
+{
+    auto closest = std::optional<Hit>{};
+    for (size_t i = 0; i < obstacles.segments.size(); ++i)
+    {
+        if (i == ignored_obstacle_id)
+            continue;
+        auto const hit = segment_hit(p1, p2, obstacles.segments[i], static_cast<uint32_t>(i));
+        if (hit && is_closer(*hit, closest))
+            closest = hit;
+    }
+    for (size_t i = 0; i < obstacles.circles.size(); ++i)
+    {
+        if (obstacles.segments.size() + i == ignored_obstacle_id)
+            continue;
+        auto const hit = circle_hit(p1, p2, obstacles.circles[i], static_cast<uint32_t>(obstacles.segments.size() + i));
+        if (hit && is_closer(*hit, closest))
+            closest = hit;
+    }
+    return closest;
+}
+
+} // namespace sim
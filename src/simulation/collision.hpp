@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace sim {
+
+struct Segment {
+    glm::vec2 start{};
+    glm::vec2 end{};
+};
+
+struct Circle {
+    glm::vec2 center{};
+    float     radius{};
+};
+
+/// The static colliders the particles bounce on
+struct Obstacles {
+    std::vector<Segment> segments{};
+    std::vector<Circle>  circles{};
+};
+
+/// An obstacle id that matches no obstacle
+inline constexpr uint32_t no_obstacle = 0xFFFFFFFFu;
+
+/// Where a moving particle hits an obstacle
+struct Hit {
+    glm::vec2 point{};
+    glm::vec2 normal{};           /// Not necessarily facing the particle, but normalized
+    float     distance_squared{}; /// From the start of the particle's path
+    uint32_t  obstacle_id{};      /// Segments are numbered first, then circles: a circle's id is `segments.size() + its index`
+};
+
+/// Returns true iff the segments [p1, p2] and [q1, q2] intersect, in which case `intersection` is set to the intersection point.
+auto segment_intersect(glm::vec2 const& p1, glm::vec2 const& p2, glm::vec2 const& q1, glm::vec2 const& q2, glm::vec2& intersection) -> bool;
+
+/// Returns true iff the segment [p1, p2] crosses the circle, in which case `intersection` is set to the first crossing point.
+auto segment_circle_intersect(glm::vec2 const& p1, glm::vec2 const& p2, glm::vec2 const& circle_center, float circle_radius, glm::vec2& intersection) -> bool;
+
+auto segment_hit(glm::vec2 const& p1, glm::vec2 const& p2, Segment const&, uint32_t obstacle_id) -> std::optional<Hit>;
+auto circle_hit(glm::vec2 const& p1, glm::vec2 const& p2, Circle const&, uint32_t obstacle_id) -> std::optional<Hit>;
+
+/// The Hit of a path starting at p1 that crosses the obstacle at `point`, e.g. as found by the batch kernels.
+auto make_segment_hit(glm::vec2 const& p1, glm::vec2 const& point, Segment const&, uint32_t obstacle_id) -> Hit;
+auto make_circle_hit(glm::vec2 const& p1, glm::vec2 const& point, Circle const&, uint32_t obstacle_id) -> Hit;
+
+/// Returns true iff `candidate` should be preferred over `current`: it is closer, or as close and with a smaller id.
+/// The id breaks ties so that the result doesn't depend on the order in which obstacles are tested.
+inline auto is_closer(Hit const& candidate, std::optional<Hit> const& current) -> bool
+{
+    return !current
+           || candidate.distance_squared < current->distance_squared
+           || (candidate.distance_squared == current->distance_squared && candidate.obstacle_id < current->obstacle_id);
+}
+
+/// Tests the path [p1, p2] against every obstacle but `ignored_obstacle_id`, and returns the hit closest to p1.
+auto closest_hit(glm::vec2 const& p1, glm::vec2 const& p2, Obstacles const&, uint32_t ignored_obstacle_id = no_obstacle) -> std::optional<Hit>;
+
+} // namespace sim
@@ -0,0 +1,118 @@
+#include "collision_batch.hpp"
+#include <cassert>
+#include "simd.hpp"
+
+namespace sim {
+
+static auto segment_intersect_scalar(Paths const& paths, size_t begin, size_t end, Segment const& segment, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; ++i)
+    {
+        glm::vec2 intersection;
+        if (segment_intersect({paths.start_x[i], paths.start_y[i]}, {paths.end_x[i], paths.end_y[i]}, segment.start, segment.end, intersection))
+        {
+            mask |= 1u << i;
+            intersection_x[i] = intersection.x;
+            intersection_y[i] = intersection.y;
+        }
+    }
+    return mask;
+}
+
+static auto segment_circle_intersect_scalar(Paths const& paths, size_t begin, size_t end, Circle const& circle, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; ++i)
+    {
+        glm::vec2 intersection;
+        if (segment_circle_intersect({paths.start_x[i], paths.start_y[i]}, {paths.end_x[i], paths.end_y[i]}, circle.center, circle.radius, intersection))
+        {
+            mask |= 1u << i;
+            intersection_x[i] = intersection.x;
+            intersection_y[i] = intersection.y;
+        }
+    }
+    return mask;
+}
+
+template<typename Kernel>
+struct KernelsPerLevel {
+    Kernel scalar;
+    Kernel sse4;
+    Kernel avx2;
+    Kernel avx512;
+};
+
+/// Runs the widest kernel available on as many paths as it can, then the narrower ones on the remaining paths
+template<typename Kernel, typename Obstacle>
+static auto dispatch(KernelsPerLevel<Kernel> const& kernels, Paths const& paths, size_t count, Obstacle const& obstacle, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    assert(count <= max_batch_size);
+
+    uint32_t mask  = 0;
+    size_t   begin = 0;
+    auto     run   = [&](Kernel kernel, size_t lanes_count) {
+        size_t const end = begin + (count - begin) / lanes_count * lanes_count;
+        if (end != begin)
+            mask |= kernel(paths, begin, end, obstacle, intersection_x, intersection_y);
+        begin = end;
+    };
+
+    switch (simd_level())
+    {
+    case SimdLevel::AVX512:
+        run(kernels.avx512, 16);
+        [[fallthrough]];
+    case SimdLevel::AVX2:
+        run(kernels.avx2, 8);
+        [[fallthrough]];
+    case SimdLevel::SSE4:
+        run(kernels.sse4, 4);
+        [[fallthrough]];
+    case SimdLevel::Scalar:
+        run(kernels.scalar, 1);
+    }
+    return mask;
+}
+
+#if SIM_X86
+static constexpr auto segment_kernels = KernelsPerLevel<internal::SegmentBatchKernel>{
+    .scalar = &segment_intersect_scalar,
+    .sse4   = &internal::segment_intersect_sse4,
+    .avx2   = &internal::segment_intersect_avx2,
+    .avx512 = &internal::segment_intersect_avx512,
+};
+static constexpr auto circle_kernels = KernelsPerLevel<internal::CircleBatchKernel>{
+    .scalar = &segment_circle_intersect_scalar,
+    .sse4   = &internal::segment_circle_intersect_sse4,
+    .avx2   = &internal::segment_circle_intersect_avx2,
+    .avx512 = &internal::segment_circle_intersect_avx512,
+};
+#else
+// simd_level() is always Scalar
+static constexpr auto segment_kernels = KernelsPerLevel<internal::SegmentBatchKernel>{
+    .scalar = &segment_intersect_scalar,
+    .sse4   = &segment_intersect_scalar,
+    .avx2   = &segment_intersect_scalar,
+    .avx512 = &segment_intersect_scalar,
+};
+static constexpr auto circle_kernels = KernelsPerLevel<internal::CircleBatchKernel>{
+    .scalar = &segment_circle_intersect_scalar,
+    .sse4   = &segment_circle_intersect_scalar,
+    .avx2   = &segment_circle_intersect_scalar,
+    .avx512 = &segment_circle_intersect_scalar,
+};
+#endif
+
+auto segment_intersect_batch(Paths const& paths, size_t count, Segment const& segment, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    return dispatch(segment_kernels, paths, count, segment, intersection_x, intersection_y);
+}
+
+auto segment_circle_intersect_batch(Paths const& paths, size_t count, Circle const& circle, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    return dispatch(circle_kernels, paths, count, circle, intersection_x, intersection_y);
+}
+
+} // namespace sim
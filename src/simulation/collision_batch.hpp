@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "collision.hpp"
+
+namespace sim {
+
+/// The batch kernels test at most that many paths at once
+inline constexpr size_t max_batch_size = 32;
+
+/// The paths [start, end] of several particles, as columns
+struct Paths {
+    float const* start_x;
+    float const* start_y;
+    float const* end_x;
+    float const* end_y;
+};
+
+/// Batched segment_intersect(): tests the first `count` paths against the segment, using the SIMD instructions of simd_level().
+/// Returns a mask whose bit i is set iff the i-th path crosses the segment, in which case (intersection_x[i], intersection_y[i]) is the intersection point. The other intersections are left unspecified.
+/// Bit-for-bit the same results as segment_intersect(), whatever the SIMD level. `count` must be at most max_batch_size.
+auto segment_intersect_batch(Paths const&, size_t count, Segment const&, float* intersection_x, float* intersection_y) -> uint32_t;
+
+/// Batched segment_circle_intersect(). Same contract as segment_intersect_batch().
+auto segment_circle_intersect_batch(Paths const&, size_t count, Circle const&, float* intersection_x, float* intersection_y) -> uint32_t;
+
+namespace internal {
+// One implementation per SIMD level. They process the paths [begin, end), whose count must be a multiple of their number of lanes, and fill the corresponding bits of the mask.
+// The x86 ones are only defined on x86, in collision_batch_x86.cpp.
+using SegmentBatchKernel = auto (*)(Paths const&, size_t begin, size_t end, Segment const&, float*, float*) -> uint32_t;
+using CircleBatchKernel  = auto (*)(Paths const&, size_t begin, size_t end, Circle const&, float*, float*) -> uint32_t;
+
+auto segment_intersect_sse4(Paths const&, size_t begin, size_t end, Segment const&, float* intersection_x, float* intersection_y) -> uint32_t;
+auto segment_intersect_avx2(Paths const&, size_t begin, size_t end, Segment const&, float* intersection_x, float* intersection_y) -> uint32_t;
+auto segment_intersect_avx512(Paths const&, size_t begin, size_t end, Segment const&, float* intersection_x, float* intersection_y) -> uint32_t;
+auto segment_circle_intersect_sse4(Paths const&, size_t begin, size_t end, Circle const&, float* intersection_x, float* intersection_y) -> uint32_t;
+auto segment_circle_intersect_avx2(Paths const&, size_t begin, size_t end, Circle const&, float* intersection_x, float* intersection_y) -> uint32_t;
+auto segment_circle_intersect_avx512(Paths const&, size_t begin, size_t end, Circle const&, float* intersection_x, float* intersection_y) -> uint32_t;
+} // namespace internal
+
+} // namespace sim
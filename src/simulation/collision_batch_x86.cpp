@@ -0,0 +1,273 @@
+// The SSE4, AVX2 and AVX-512 versions of the batch kernels.
+// Each function is compiled for its own instruction set, and only called when simd_level() allows it.
+//
+// They perform exactly the same floating-point operations as segment_intersect() and segment_circle_intersect(), in the same order, so that they give bit-for-bit the same results:
+// - The operations on the obstacle alone (e.g. q2 - q1, or radius²) are done once in scalar, like the reference does them.
+// - Comparisons use the ordered predicates, so that NaNs fail them like in scalar code.
+// - Negations flip the sign bit, like the unary minus does, instead of subtracting from 0.
+// - The library is compiled without floating-point contraction, so that no FMA fuses a multiplication with an addition in one version and not in the other.
+
+#include "collision_batch.hpp"
+#include "simd.hpp"
+#if SIM_X86
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SIM_TARGET(instruction_set) __attribute__((target(instruction_set)))
+#else
+#define SIM_TARGET(instruction_set) // MSVC lets us use any intrinsic anywhere
+#endif
+
+namespace sim::internal {
+
+// ---SSE4---
+
+SIM_TARGET("sse4.1")
+auto segment_intersect_sse4(Paths const& paths, size_t begin, size_t end, Segment const& segment, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    __m128 const q1_x = _mm_set1_ps(segment.start.x);
+    __m128 const q1_y = _mm_set1_ps(segment.start.y);
+    __m128 const s_x  = _mm_set1_ps(segment.end.x - segment.start.x);
+    __m128 const s_y  = _mm_set1_ps(segment.end.y - segment.start.y);
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const one  = _mm_set1_ps(1.f);
+
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; i += 4)
+    {
+        __m128 const p1_x = _mm_loadu_ps(paths.start_x + i);
+        __m128 const p1_y = _mm_loadu_ps(paths.start_y + i);
+        __m128 const r_x  = _mm_sub_ps(_mm_loadu_ps(paths.end_x + i), p1_x);
+        __m128 const r_y  = _mm_sub_ps(_mm_loadu_ps(paths.end_y + i), p1_y);
+
+        __m128 const rxs  = _mm_sub_ps(_mm_mul_ps(r_x, s_y), _mm_mul_ps(r_y, s_x));
+        __m128 const qp_x = _mm_sub_ps(q1_x, p1_x);
+        __m128 const qp_y = _mm_sub_ps(q1_y, p1_y);
+        __m128 const t    = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(qp_x, s_y), _mm_mul_ps(qp_y, s_x)), rxs);
+        __m128 const u    = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(qp_x, r_y), _mm_mul_ps(qp_y, r_x)), rxs);
+
+        __m128 hit = _mm_cmpneq_ps(rxs, zero);
+        hit        = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, one)));
+        hit        = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+
+        _mm_storeu_ps(intersection_x + i, _mm_add_ps(p1_x, _mm_mul_ps(t, r_x)));
+        _mm_storeu_ps(intersection_y + i, _mm_add_ps(p1_y, _mm_mul_ps(t, r_y)));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << i;
+    }
+    return mask;
+}
+
+SIM_TARGET("sse4.1")
+auto segment_circle_intersect_sse4(Paths const& paths, size_t begin, size_t end, Circle const& circle, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    __m128 const center_x       = _mm_set1_ps(circle.center.x);
+    __m128 const center_y       = _mm_set1_ps(circle.center.y);
+    __m128 const radius_squared = _mm_set1_ps(circle.radius * circle.radius);
+    __m128 const zero           = _mm_setzero_ps();
+    __m128 const one            = _mm_set1_ps(1.f);
+    __m128 const two            = _mm_set1_ps(2.f);
+    __m128 const four           = _mm_set1_ps(4.f);
+    __m128 const sign_bit       = _mm_set1_ps(-0.f);
+
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; i += 4)
+    {
+        __m128 const p1_x = _mm_loadu_ps(paths.start_x + i);
+        __m128 const p1_y = _mm_loadu_ps(paths.start_y + i);
+        __m128 const d_x  = _mm_sub_ps(_mm_loadu_ps(paths.end_x + i), p1_x);
+        __m128 const d_y  = _mm_sub_ps(_mm_loadu_ps(paths.end_y + i), p1_y);
+        __m128 const f_x  = _mm_sub_ps(p1_x, center_x);
+        __m128 const f_y  = _mm_sub_ps(p1_y, center_y);
+
+        __m128 const a            = _mm_add_ps(_mm_mul_ps(d_x, d_x), _mm_mul_ps(d_y, d_y));
+        __m128 const b            = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(f_x, d_x), _mm_mul_ps(f_y, d_y)));
+        __m128 const c            = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(f_x, f_x), _mm_mul_ps(f_y, f_y)), radius_squared);
+        __m128 const discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_mul_ps(four, a), c));
+
+        __m128 const sqrt_discriminant = _mm_sqrt_ps(discriminant);
+        __m128 const minus_b           = _mm_xor_ps(b, sign_bit);
+        __m128 const two_a             = _mm_mul_ps(two, a);
+        __m128 const t1                = _mm_div_ps(_mm_sub_ps(minus_b, sqrt_discriminant), two_a);
+        __m128 const t2                = _mm_div_ps(_mm_add_ps(minus_b, sqrt_discriminant), two_a);
+
+        __m128 const t1_hits = _mm_and_ps(_mm_cmpge_ps(t1, zero), _mm_cmple_ps(t1, one));
+        __m128 const t2_hits = _mm_and_ps(_mm_cmpge_ps(t2, zero), _mm_cmple_ps(t2, one));
+        __m128 const t       = _mm_blendv_ps(t2, t1, t1_hits);
+        __m128 const hit     = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_or_ps(t1_hits, t2_hits));
+
+        _mm_storeu_ps(intersection_x + i, _mm_add_ps(p1_x, _mm_mul_ps(t, d_x)));
+        _mm_storeu_ps(intersection_y + i, _mm_add_ps(p1_y, _mm_mul_ps(t, d_y)));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << i;
+    }
+    return mask;
+}
+
+// ---AVX2---
+
+SIM_TARGET("avx2")
+auto segment_intersect_avx2(Paths const& paths, size_t begin, size_t end, Segment const& segment, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    __m256 const q1_x = _mm256_set1_ps(segment.start.x);
+    __m256 const q1_y = _mm256_set1_ps(segment.start.y);
+    __m256 const s_x  = _mm256_set1_ps(segment.end.x - segment.start.x);
+    __m256 const s_y  = _mm256_set1_ps(segment.end.y - segment.start.y);
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const one  = _mm256_set1_ps(1.f);
+
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; i += 8)
+    {
+        __m256 const p1_x = _mm256_loadu_ps(paths.start_x + i);
+        __m256 const p1_y = _mm256_loadu_ps(paths.start_y + i);
+        __m256 const r_x  = _mm256_sub_ps(_mm256_loadu_ps(paths.end_x + i), p1_x);
+        __m256 const r_y  = _mm256_sub_ps(_mm256_loadu_ps(paths.end_y + i), p1_y);
+
+        __m256 const rxs  = _mm256_sub_ps(_mm256_mul_ps(r_x, s_y), _mm256_mul_ps(r_y, s_x));
+        __m256 const qp_x = _mm256_sub_ps(q1_x, p1_x);
+        __m256 const qp_y = _mm256_sub_ps(q1_y, p1_y);
+        __m256 const t    = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(qp_x, s_y), _mm256_mul_ps(qp_y, s_x)), rxs);
+        __m256 const u    = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(qp_x, r_y), _mm256_mul_ps(qp_y, r_x)), rxs);
+
+        __m256 hit = _mm256_cmp_ps(rxs, zero, _CMP_NEQ_UQ);
+        hit        = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, one, _CMP_LE_OQ)));
+        hit        = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+
+        _mm256_storeu_ps(intersection_x + i, _mm256_add_ps(p1_x, _mm256_mul_ps(t, r_x)));
+        _mm256_storeu_ps(intersection_y + i, _mm256_add_ps(p1_y, _mm256_mul_ps(t, r_y)));
+        mask |= static_cast<uint32_t>(_mm256_movemask_ps(hit)) << i;
+    }
+    return mask;
+}
+
+SIM_TARGET("avx2")
+auto segment_circle_intersect_avx2(Paths const& paths, size_t begin, size_t end, Circle const& circle, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    __m256 const center_x       = _mm256_set1_ps(circle.center.x);
+    __m256 const center_y       = _mm256_set1_ps(circle.center.y);
+    __m256 const radius_squared = _mm256_set1_ps(circle.radius * circle.radius);
+    __m256 const zero           = _mm256_setzero_ps();
+    __m256 const one            = _mm256_set1_ps(1.f);
+    __m256 const two            = _mm256_set1_ps(2.f);
+    __m256 const four           = _mm256_set1_ps(4.f);
+    __m256 const sign_bit       = _mm256_set1_ps(-0.f);
+
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; i += 8)
+    {
+        __m256 const p1_x = _mm256_loadu_ps(paths.start_x + i);
+        __m256 const p1_y = _mm256_loadu_ps(paths.start_y + i);
+        __m256 const d_x  = _mm256_sub_ps(_mm256_loadu_ps(paths.end_x + i), p1_x);
+        __m256 const d_y  = _mm256_sub_ps(_mm256_loadu_ps(paths.end_y + i), p1_y);
+        __m256 const f_x  = _mm256_sub_ps(p1_x, center_x);
+        __m256 const f_y  = _mm256_sub_ps(p1_y, center_y);
+
+        __m256 const a            = _mm256_add_ps(_mm256_mul_ps(d_x, d_x), _mm256_mul_ps(d_y, d_y));
+        __m256 const b            = _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(f_x, d_x), _mm256_mul_ps(f_y, d_y)));
+        __m256 const c            = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(f_x, f_x), _mm256_mul_ps(f_y, f_y)), radius_squared);
+        __m256 const discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_mul_ps(four, a), c));
+
+        __m256 const sqrt_discriminant = _mm256_sqrt_ps(discriminant);
+        __m256 const minus_b           = _mm256_xor_ps(b, sign_bit);
+        __m256 const two_a             = _mm256_mul_ps(two, a);
+        __m256 const t1                = _mm256_div_ps(_mm256_sub_ps(minus_b, sqrt_discriminant), two_a);
+        __m256 const t2                = _mm256_div_ps(_mm256_add_ps(minus_b, sqrt_discriminant), two_a);
+
+        __m256 const t1_hits = _mm256_and_ps(_mm256_cmp_ps(t1, zero, _CMP_GE_OQ), _mm256_cmp_ps(t1, one, _CMP_LE_OQ));
+        __m256 const t2_hits = _mm256_and_ps(_mm256_cmp_ps(t2, zero, _CMP_GE_OQ), _mm256_cmp_ps(t2, one, _CMP_LE_OQ));
+        __m256 const t       = _mm256_blendv_ps(t2, t1, t1_hits);
+        __m256 const hit     = _mm256_and_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ), _mm256_or_ps(t1_hits, t2_hits));
+
+        _mm256_storeu_ps(intersection_x + i, _mm256_add_ps(p1_x, _mm256_mul_ps(t, d_x)));
+        _mm256_storeu_ps(intersection_y + i, _mm256_add_ps(p1_y, _mm256_mul_ps(t, d_y)));
+        mask |= static_cast<uint32_t>(_mm256_movemask_ps(hit)) << i;
+    }
+    return mask;
+}
+
+// ---AVX-512---
+
+SIM_TARGET("avx512f")
+auto segment_intersect_avx512(Paths const& paths, size_t begin, size_t end, Segment const& segment, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    __m512 const q1_x = _mm512_set1_ps(segment.start.x);
+    __m512 const q1_y = _mm512_set1_ps(segment.start.y);
+    __m512 const s_x  = _mm512_set1_ps(segment.end.x - segment.start.x);
+    __m512 const s_y  = _mm512_set1_ps(segment.end.y - segment.start.y);
+    __m512 const zero = _mm512_setzero_ps();
+    __m512 const one  = _mm512_set1_ps(1.f);
+
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; i += 16)
+    {
+        __m512 const p1_x = _mm512_loadu_ps(paths.start_x + i);
+        __m512 const p1_y = _mm512_loadu_ps(paths.start_y + i);
+        __m512 const r_x  = _mm512_sub_ps(_mm512_loadu_ps(paths.end_x + i), p1_x);
+        __m512 const r_y  = _mm512_sub_ps(_mm512_loadu_ps(paths.end_y + i), p1_y);
+
+        __m512 const rxs  = _mm512_sub_ps(_mm512_mul_ps(r_x, s_y), _mm512_mul_ps(r_y, s_x));
+        __m512 const qp_x = _mm512_sub_ps(q1_x, p1_x);
+        __m512 const qp_y = _mm512_sub_ps(q1_y, p1_y);
+        __m512 const t    = _mm512_div_ps(_mm512_sub_ps(_mm512_mul_ps(qp_x, s_y), _mm512_mul_ps(qp_y, s_x)), rxs);
+        __m512 const u    = _mm512_div_ps(_mm512_sub_ps(_mm512_mul_ps(qp_x, r_y), _mm512_mul_ps(qp_y, r_x)), rxs);
+
+        __mmask16 hit = _mm512_cmp_ps_mask(rxs, zero, _CMP_NEQ_UQ);
+        hit           = _mm512_mask_cmp_ps_mask(hit, t, zero, _CMP_GE_OQ);
+        hit           = _mm512_mask_cmp_ps_mask(hit, t, one, _CMP_LE_OQ);
+        hit           = _mm512_mask_cmp_ps_mask(hit, u, zero, _CMP_GE_OQ);
+        hit           = _mm512_mask_cmp_ps_mask(hit, u, one, _CMP_LE_OQ);
+
+        _mm512_storeu_ps(intersection_x + i, _mm512_add_ps(p1_x, _mm512_mul_ps(t, r_x)));
+        _mm512_storeu_ps(intersection_y + i, _mm512_add_ps(p1_y, _mm512_mul_ps(t, r_y)));
+        mask |= static_cast<uint32_t>(hit) << i;
+    }
+    return mask;
+}
+
+SIM_TARGET("avx512f")
+auto segment_circle_intersect_avx512(Paths const& paths, size_t begin, size_t end, Circle const& circle, float* intersection_x, float* intersection_y) -> uint32_t
+{
+    __m512 const  center_x       = _mm512_set1_ps(circle.center.x);
+    __m512 const  center_y       = _mm512_set1_ps(circle.center.y);
+    __m512 const  radius_squared = _mm512_set1_ps(circle.radius * circle.radius);
+    __m512 const  zero           = _mm512_setzero_ps();
+    __m512 const  one            = _mm512_set1_ps(1.f);
+    __m512 const  two            = _mm512_set1_ps(2.f);
+    __m512 const  four           = _mm512_set1_ps(4.f);
+    __m512i const sign_bit       = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+
+    uint32_t mask = 0;
+    for (size_t i = begin; i < end; i += 16)
+    {
+        __m512 const p1_x = _mm512_loadu_ps(paths.start_x + i);
+        __m512 const p1_y = _mm512_loadu_ps(paths.start_y + i);
+        __m512 const d_x  = _mm512_sub_ps(_mm512_loadu_ps(paths.end_x + i), p1_x);
+        __m512 const d_y  = _mm512_sub_ps(_mm512_loadu_ps(paths.end_y + i), p1_y);
+        __m512 const f_x  = _mm512_sub_ps(p1_x, center_x);
+        __m512 const f_y  = _mm512_sub_ps(p1_y, center_y);
+
+        __m512 const a            = _mm512_add_ps(_mm512_mul_ps(d_x, d_x), _mm512_mul_ps(d_y, d_y));
+        __m512 const b            = _mm512_mul_ps(two, _mm512_add_ps(_mm512_mul_ps(f_x, d_x), _mm512_mul_ps(f_y, d_y)));
+        __m512 const c            = _mm512_sub_ps(_mm512_add_ps(_mm512_mul_ps(f_x, f_x), _mm512_mul_ps(f_y, f_y)), radius_squared);
+        __m512 const discriminant = _mm512_sub_ps(_mm512_mul_ps(b, b), _mm512_mul_ps(_mm512_mul_ps(four, a), c));
+
+        __m512 const sqrt_discriminant = _mm512_maskz_sqrt_ps(0xFFFF, discriminant); // Same as _mm512_sqrt_ps(), which makes GCC 12 warn about its own header
+        __m512 const minus_b           = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(b), sign_bit)); // _mm512_xor_ps needs AVX512DQ
+        __m512 const two_a             = _mm512_mul_ps(two, a);
+        __m512 const t1                = _mm512_div_ps(_mm512_sub_ps(minus_b, sqrt_discriminant), two_a);
+        __m512 const t2                = _mm512_div_ps(_mm512_add_ps(minus_b, sqrt_discriminant), two_a);
+
+        __mmask16 const t1_hits = _mm512_mask_cmp_ps_mask(_mm512_cmp_ps_mask(t1, zero, _CMP_GE_OQ), t1, one, _CMP_LE_OQ);
+        __mmask16 const t2_hits = _mm512_mask_cmp_ps_mask(_mm512_cmp_ps_mask(t2, zero, _CMP_GE_OQ), t2, one, _CMP_LE_OQ);
+        __m512 const    t       = _mm512_mask_blend_ps(t1_hits, t2, t1);
+        __mmask16 const hit     = _mm512_mask_cmp_ps_mask(t1_hits | t2_hits, discriminant, zero, _CMP_GE_OQ);
+
+        _mm512_storeu_ps(intersection_x + i, _mm512_add_ps(p1_x, _mm512_mul_ps(t, d_x)));
+        _mm512_storeu_ps(intersection_y + i, _mm512_add_ps(p1_y, _mm512_mul_ps(t, d_y)));
+        mask |= static_cast<uint32_t>(hit) << i;
+    }
+    return mask;
+}
+
+} // namespace sim::internal
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+#include <cmath>
+
+namespace sim {
+
+/// Bounces 10 times between 0 and 1 as `x` goes from 0 to 1
+inline auto bounce(float x) -> float
+{
+    return std::abs(std::sin(10.0f * 3.14f * x));
+}
+
+/// Goes from 0 to 1 as `t` goes from 0 to 1, slowly at both ends. The bigger `power`, the steeper the middle part.
+inline auto ease_in_out_power(float t, float power) -> float
+{
+    if (t < 0.5f)
+        return 0.5f * std::pow(2.0f * t, power);
+    else
+        return 1.0f - 0.5f * std::pow(2.0f * (1.0f - t), power);
+}
+
+} // namespace sim
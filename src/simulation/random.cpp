@@ -0,0 +1,22 @@
+#include "random.hpp"
+#include <random>
+
+namespace sim {
+
+static auto generator() -> std::default_random_engine&
+{
+    thread_local std::default_random_engine gen{std::random_device{}()};
+    return gen;
+}
+
+auto rand(float min, float max) -> float
+{
+    return std::uniform_real_distribution<float>{min, max}(generator());
+}
+
+void seed_random(uint32_t seed)
+{
+    generator().seed(seed);
+}
+
+} // namespace sim
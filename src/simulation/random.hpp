@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+namespace sim {
+
+/// Uniformly distributed random number in [min, max)
+auto rand(float min, float max) -> float;
+
+/// Each thread has its own generator, seeded randomly. This reseeds the one of the calling thread, to get reproducible runs.
+void seed_random(uint32_t seed);
+
+} // namespace sim
@@ -0,0 +1,30 @@
+#include "scene.hpp"
+#include <array>
+
+namespace sim {
+
+auto star_obstacles(float aspect_ratio) -> Obstacles
+{
+    auto const star = std::array<glm::vec2, 5>{
+        glm::vec2{0.0f, 0.5f},
+        glm::vec2{0.4755f, 0.1545f},
+        glm::vec2{0.2939f, -0.4045f},
+        glm::vec2{-0.2939f, -0.4045f},
+        glm::vec2{-0.4755f, 0.1545f},
+    };
+    auto obstacles = Obstacles{};
+    for (size_t i = 0; i < star.size(); ++i)
+        obstacles.segments.push_back({star[i], star[(i + 2) % star.size()]});
+    obstacles.segments.push_back({{-aspect_ratio, -1.f}, {+aspect_ratio, -1.f}});
+    obstacles.segments.push_back({{+aspect_ratio, -1.f}, {+aspect_ratio, +1.f}});
+    obstacles.segments.push_back({{+aspect_ratio, +1.f}, {-aspect_ratio, +1.f}});
+    obstacles.segments.push_back({{-aspect_ratio, +1.f}, {-aspect_ratio, -1.f}});
+    obstacles.circles = {
+        {{-0.5f, 0.0f}, 0.15f},
+        {{0.5f, 0.4f}, 0.1f},
+        {{0.0f, -0.5f}, 0.2f},
+    };
+    return obstacles;
+}
+
+} // namespace sim
@@ -0,0 +1,9 @@
+#pragma once
+#include "collision.hpp"
+
+namespace sim {
+
+/// The obstacles of the app: a star in the middle of the window, three circles, and the borders of the window.
+auto star_obstacles(float aspect_ratio) -> Obstacles;
+
+} // namespace sim
@@ -0,0 +1,93 @@
+#include "simd.hpp"
+#include <atomic>
+#include <cassert>
+#if SIM_X86 && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace sim {
+
+auto to_string(SimdLevel level) -> char const*
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        return "Scalar";
+    case SimdLevel::SSE4:
+        return "SSE4";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::AVX512:
+        return "AVX512";
+    }
+    return "";
+}
+
+#if SIM_X86 && defined(_MSC_VER)
+static auto detect() -> SimdLevel
+{
+    int info[4];
+    __cpuid(info, 1);
+    bool const sse4    = (info[2] & (1 << 19)) != 0;
+    bool const osxsave = (info[2] & (1 << 27)) != 0;
+    bool const avx     = (info[2] & (1 << 28)) != 0;
+    if (!sse4)
+        return SimdLevel::Scalar;
+    if (!osxsave || !avx)
+        return SimdLevel::SSE4;
+
+    // The OS must also save the AVX registers on context switches
+    auto const xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    bool const avx2    = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+    bool const avx512f = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+    if (avx512f && avx2)
+        return SimdLevel::AVX512;
+    if (avx2)
+        return SimdLevel::AVX2;
+    return SimdLevel::SSE4;
+}
+#elif SIM_X86
+static auto detect() -> SimdLevel
+{
+    // Also checks that the OS saves the registers on context switches
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return SimdLevel::SSE4;
+    return SimdLevel::Scalar;
+}
+#else
+static auto detect() -> SimdLevel
+{
+    return SimdLevel::Scalar;
+}
+#endif
+
+auto detected_simd_level() -> SimdLevel
+{
+    static SimdLevel const level = detect();
+    return level;
+}
+
+static auto current_level() -> std::atomic<SimdLevel>&
+{
+    static auto level = std::atomic<SimdLevel>{detected_simd_level()};
+    return level;
+}
+
+auto simd_level() -> SimdLevel
+{
+    return current_level().load(std::memory_order_relaxed);
+}
+
+void set_simd_level(SimdLevel level)
+{
+    assert(level <= detected_simd_level() && "This CPU doesn't support this SIMD level");
+    current_level().store(level, std::memory_order_relaxed);
+}
+
+} // namespace sim
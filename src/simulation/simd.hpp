@@ -0,0 +1,29 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIM_X86 1
+#else
+#define SIM_X86 0
+#endif
+
+namespace sim {
+
+/// The instruction sets the batch kernels can use, from the least to the most capable.
+enum class SimdLevel {
+    Scalar,
+    SSE4,   /// 4 lanes
+    AVX2,   /// 8 lanes
+    AVX512, /// 16 lanes
+};
+
+auto to_string(SimdLevel) -> char const*;
+
+/// The most capable level supported by this CPU and OS. Always Scalar on non-x86 platforms.
+auto detected_simd_level() -> SimdLevel;
+
+/// The level currently used by the batch kernels. Defaults to detected_simd_level().
+auto simd_level() -> SimdLevel;
+/// Lowers the level used by the batch kernels, e.g. to compare the levels with each other. The level can't go above detected_simd_level().
+void set_simd_level(SimdLevel);
+
+} // namespace sim
@@ -0,0 +1,104 @@
+#include "update.hpp"
+#include <array>
+
+namespace sim {
+
+static auto reflect(glm::vec2 const& velocity, glm::vec2 const& normal) -> glm::vec2
+{
+    return velocity - 2.0f * glm::dot(velocity, normal) * normal;
+}
+
+/// Moves the particle to `new_pos`, bouncing on `hit` and on the obstacles found by `find_hit(start, end, ignored_obstacle_id)` on the rest of the way.
+/// After bouncing on an obstacle, the next leg ignores it: it starts next to the obstacle and moves away from it, so it could only hit it again because of rounding errors.
+template<typename FindHit>
+static void move_and_bounce(glm::vec2& position, glm::vec2& velocity, glm::vec2 const& new_pos, std::optional<Hit> hit, FindHit&& find_hit)
+{
+    glm::vec2 leg_start = position;
+    glm::vec2 leg_end   = new_pos;
+    for (size_t contact = 0; contact < max_contacts_per_step && hit; ++contact)
+    {
+        glm::vec2 const normal_towards_particle = glm::dot(velocity, hit->normal) < 0.f ? hit->normal : -hit->normal;
+        velocity                                = reflect(velocity, hit->normal);
+
+        float const distance_behind = glm::length(leg_end - hit->point);
+        leg_start                   = hit->point + normal_towards_particle * contact_offset;
+        leg_end                     = leg_start + glm::normalize(velocity) * distance_behind;
+        hit                         = find_hit(leg_start, leg_end, hit->obstacle_id);
+    }
+    // Out of contacts while the last leg still crosses an obstacle: stop at the last contact rather than going through it
+    position = hit ? leg_start : leg_end;
+}
+
+void step_particle(glm::vec2& position, glm::vec2& velocity, float dt, ColliderBVH const& colliders)
+{
+    glm::vec2 const new_pos  = position + velocity * dt;
+    auto const      find_hit = [&](glm::vec2 const& p1, glm::vec2 const& p2, uint32_t ignored_obstacle_id) {
+        return colliders.closest_hit(p1, p2, ignored_obstacle_id);
+    };
+    move_and_bounce(position, velocity, new_pos, find_hit(position, new_pos, no_obstacle), find_hit);
+}
+
+void step_particle(glm::vec2& position, glm::vec2& velocity, float dt, Obstacles const& obstacles)
+{
+    glm::vec2 const new_pos  = position + velocity * dt;
+    auto const      find_hit = [&](glm::vec2 const& p1, glm::vec2 const& p2, uint32_t ignored_obstacle_id) {
+        return closest_hit(p1, p2, obstacles, ignored_obstacle_id);
+    };
+    move_and_bounce(position, velocity, new_pos, find_hit(position, new_pos, no_obstacle), find_hit);
+}
+
+static_assert(block_size <= max_batch_size, "A whole block must fit in one call to the batch kernels");
+
+void update_particles(ParticleSystem& particles, ColliderBVH const& colliders, float dt, size_t begin, size_t end)
+{
+    auto const c = particles.columns();
+    // Moves a block of particles, then finds all their collisions at once with the batch kernels
+    particles.for_each_block(begin, end, [&](size_t block_begin, size_t block_end) {
+        size_t const count = block_end - block_begin;
+
+        auto new_x = std::array<float, block_size>{};
+        auto new_y = std::array<float, block_size>{};
+        for (size_t j = 0; j < count; ++j)
+        {
+            size_t const i = block_begin + j;
+            c.age[i] += dt;
+            c.previous_position_x[i] = c.position_x[i];
+            c.previous_position_y[i] = c.position_y[i];
+            new_x[j]                 = c.position_x[i] + c.velocity_x[i] * dt;
+            new_y[j]                 = c.position_y[i] + c.velocity_y[i] * dt;
+        }
+
+        auto hits = std::array<std::optional<Hit>, block_size>{};
+        colliders.closest_hits({c.position_x + block_begin, c.position_y + block_begin, new_x.data(), new_y.data()}, count, hits.data());
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            size_t const i        = block_begin + j;
+            auto         position = glm::vec2{c.position_x[i], c.position_y[i]};
+            auto         velocity = glm::vec2{c.velocity_x[i], c.velocity_y[i]};
+            move_and_bounce(position, velocity, {new_x[j], new_y[j]}, hits[j], [&](glm::vec2 const& p1, glm::vec2 const& p2, uint32_t ignored_obstacle_id) {
+                return colliders.closest_hit(p1, p2, ignored_obstacle_id);
+            });
+            c.position_x[i] = position.x;
+            c.position_y[i] = position.y;
+            c.velocity_x[i] = velocity.x;
+            c.velocity_y[i] = velocity.y;
+        }
+    });
+}
+
+void update_particles(ParticleSystem& particles, ColliderBVH const& colliders, float dt)
+{
+    update_particles(particles, colliders, dt, 0, particles.size());
+}
+
+void update_particles(ParticleSystem& particles, ColliderBVH const& colliders, float dt, JobSystem& jobs)
+{
+    // Big enough to amortize the cost of stealing, small enough to balance particles that collide a lot with those that don't
+    size_t const grain_size = 4 * block_size;
+    jobs.parallel_for(0, particles.size(), grain_size, [&](size_t begin, size_t end) {
+        update_particles(particles, colliders, dt, begin, end);
+    });
+}
+
+} // namespace sim
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include "ColliderBVH.hpp"
+#include "JobSystem.hpp"
+#include "ParticleSystem.hpp"
+#include "collision.hpp"
+#include "glm/glm.hpp"
+
+namespace sim {
+
+/// How many times a particle can bounce during a single step.
+/// If the rest of the way still crosses an obstacle after that many bounces (e.g. when wedged in a corner of the star), the particle stops for the rest of the step at its last contact, so that it never goes through a wall.
+inline constexpr size_t max_contacts_per_step = 8;
+/// Particles bounce that far from the obstacles instead of exactly on them.
+/// Otherwise a particle could end a step exactly on an obstacle, and rounding errors couldn't tell on which side of it the particle is during the next step.
+inline constexpr float contact_offset = 1e-5f;
+
+/// Moves a particle by `velocity * dt`. Each time it crosses an obstacle on the way, it bounces on it and goes on with the rest of the way, up to max_contacts_per_step times.
+void step_particle(glm::vec2& position, glm::vec2& velocity, float dt, ColliderBVH const&);
+/// Same, but tests the path against every single obstacle. This is the reference the ColliderBVH is checked and benchmarked against.
+void step_particle(glm::vec2& position, glm::vec2& velocity, float dt, Obstacles const&);
+
+/// Ages the particles in [begin, end) by dt, moves them and makes them bounce on the obstacles.
+/// Their position before the move is kept as their previous_position().
+/// Each particle is independent from the others, so disjoint ranges can be updated concurrently.
+void update_particles(ParticleSystem&, ColliderBVH const&, float dt, size_t begin, size_t end);
+void update_particles(ParticleSystem&, ColliderBVH const&, float dt);
+/// Same, but spreads the particles over the threads of the JobSystem
+void update_particles(ParticleSystem&, ColliderBVH const&, float dt, JobSystem&);
+
+} // namespace sim
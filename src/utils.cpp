@@ -1,20 +1,8 @@
 #include "utils.hpp"
-#include <random>
 #include "opengl-framework/opengl-framework.hpp"
 
 namespace utils {
 
-static auto& generator()
-{
-    thread_local std::default_random_engine gen{std::random_device{}()};
-    return gen;
-}
-
-float rand(float min, float max)
-{
-    return std::uniform_real_distribution<float>{min, max}(generator());
-}
-
 static auto make_square_mesh() -> gl::Mesh
 {
     return gl::Mesh{gl::Mesh_Descriptor{
@@ -0,0 +1,187 @@
+// Checks that, at every SIMD level this CPU supports, the batch collision kernels give bit-for-bit the same results as the scalar
+// segment_intersect() and segment_circle_intersect(), and that ColliderBVH::closest_hits() gives the same hits as closest_hit().
+// The random paths include the edge cases: zero length, very short and very long paths, collinear paths, paths ending exactly on an obstacle, and NaNs.
+// Prints the first mismatches and exits with a non-zero code if there is any.
+//
+// Usage: Particles-batch-kernels-check
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include "simulation/ColliderBVH.hpp"
+#include "simulation/collision.hpp"
+#include "simulation/collision_batch.hpp"
+#include "simulation/random.hpp"
+#include "simulation/simd.hpp"
+
+namespace {
+
+constexpr size_t trials_per_level = 3000;
+constexpr size_t max_reported     = 10;
+
+/// The paths of one batch, as the columns the kernels read
+struct Batch {
+    std::array<float, sim::max_batch_size> start_x{};
+    std::array<float, sim::max_batch_size> start_y{};
+    std::array<float, sim::max_batch_size> end_x{};
+    std::array<float, sim::max_batch_size> end_y{};
+    size_t                                 count{};
+
+    auto paths() const -> sim::Paths { return {start_x.data(), start_y.data(), end_x.data(), end_y.data()}; }
+    auto start(size_t i) const -> glm::vec2 { return {start_x[i], start_y[i]}; }
+    auto end(size_t i) const -> glm::vec2 { return {end_x[i], end_y[i]}; }
+};
+
+auto random_batch() -> Batch
+{
+    auto batch  = Batch{};
+    batch.count = std::min(1 + static_cast<size_t>(sim::rand(0.f, static_cast<float>(sim::max_batch_size))), sim::max_batch_size);
+    for (size_t i = 0; i < batch.count; ++i)
+    {
+        auto const kind   = static_cast<int>(sim::rand(0.f, 6.f));
+        float const scale = kind == 0 ? 0.f : kind == 1 ? 1e-3f : kind == 2 ? 2.f : 0.05f;
+        batch.start_x[i]  = sim::rand(-1.f, 1.f);
+        batch.start_y[i]  = sim::rand(-1.f, 1.f);
+        batch.end_x[i]    = batch.start_x[i] + sim::rand(-1.f, 1.f) * scale;
+        batch.end_y[i]    = batch.start_y[i] + sim::rand(-1.f, 1.f) * scale;
+        if (kind == 3) // Collinear with the horizontal segment of the scene
+        {
+            batch.start_x[i] = -0.5f;
+            batch.start_y[i] = 0.f;
+            batch.end_x[i]   = 0.5f;
+            batch.end_y[i]   = 0.f;
+        }
+        if (kind == 4) // Ends exactly on the horizontal segment, and at the centers of the circles
+        {
+            batch.start_x[i] = 0.f;
+            batch.start_y[i] = -1.f;
+            batch.end_x[i]   = 0.f;
+            batch.end_y[i]   = 0.f;
+        }
+        if (kind == 5 && i % 2 == 1)
+            batch.start_x[i] = std::numeric_limits<float>::quiet_NaN();
+    }
+    return batch;
+}
+
+auto random_obstacles() -> sim::Obstacles
+{
+    auto obstacles = sim::Obstacles{};
+    for (size_t i = 0; i < 200; ++i)
+    {
+        obstacles.segments.push_back({{sim::rand(-1.f, 1.f), sim::rand(-1.f, 1.f)}, {sim::rand(-1.f, 1.f), sim::rand(-1.f, 1.f)}});
+        obstacles.circles.push_back({{sim::rand(-1.f, 1.f), sim::rand(-1.f, 1.f)}, sim::rand(0.f, 0.5f)});
+    }
+    obstacles.segments.push_back({{0.f, 0.f}, {0.f, 0.f}});
+    obstacles.segments.push_back({{-1.f, 0.f}, {1.f, 0.f}});
+    obstacles.circles.push_back({{0.f, 0.f}, 0.f});
+    obstacles.circles.push_back({{0.f, 0.f}, 0.5f});
+    return obstacles;
+}
+
+/// Compares the bits, so that NaNs and signed zeros must match too
+auto same_bits(float a, float b) -> bool
+{
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+auto same_hit(std::optional<sim::Hit> const& a, std::optional<sim::Hit> const& b) -> bool
+{
+    if (!a || !b)
+        return a.has_value() == b.has_value();
+    return a->obstacle_id == b->obstacle_id
+           && same_bits(a->point.x, b->point.x) && same_bits(a->point.y, b->point.y)
+           && same_bits(a->distance_squared, b->distance_squared);
+}
+
+struct Counters {
+    size_t tests{};
+    size_t hits{};
+    size_t mismatches{};
+
+    void record(bool ok, char const* kernel, glm::vec2 const& start, glm::vec2 const& end)
+    {
+        ++tests;
+        if (ok)
+            return;
+        if (++mismatches <= max_reported)
+            std::fprintf(stderr, "%s: mismatch for the path (%g, %g) -> (%g, %g)\n", kernel, start.x, start.y, end.x, end.y);
+    }
+};
+
+// The scalar references, with the same parameters as the batch kernels
+auto scalar_segment_intersect(glm::vec2 const& p1, glm::vec2 const& p2, sim::Segment const& segment, glm::vec2& intersection) -> bool
+{
+    return sim::segment_intersect(p1, p2, segment.start, segment.end, intersection);
+}
+
+auto scalar_circle_intersect(glm::vec2 const& p1, glm::vec2 const& p2, sim::Circle const& circle, glm::vec2& intersection) -> bool
+{
+    return sim::segment_circle_intersect(p1, p2, circle.center, circle.radius, intersection);
+}
+
+/// Compares one batch kernel call with the scalar function, path by path
+template<typename Obstacle, typename BatchKernel, typename ScalarKernel>
+void check_kernel(char const* name, Batch const& batch, Obstacle const& obstacle, BatchKernel batch_kernel, ScalarKernel scalar_kernel, Counters& counters)
+{
+    auto       intersection_x = std::array<float, sim::max_batch_size>{};
+    auto       intersection_y = std::array<float, sim::max_batch_size>{};
+    auto const mask           = batch_kernel(batch.paths(), batch.count, obstacle, intersection_x.data(), intersection_y.data());
+    for (size_t i = 0; i < batch.count; ++i)
+    {
+        auto       expected_intersection = glm::vec2{};
+        bool const expected_hit          = scalar_kernel(batch.start(i), batch.end(i), obstacle, expected_intersection);
+        bool const hit                   = (mask >> i) & 1u;
+        counters.hits += expected_hit;
+        counters.record(hit == expected_hit
+                            && (!hit || (same_bits(intersection_x[i], expected_intersection.x) && same_bits(intersection_y[i], expected_intersection.y))),
+                        name, batch.start(i), batch.end(i));
+    }
+}
+
+auto check_level(sim::SimdLevel level, sim::Obstacles const& obstacles, sim::ColliderBVH const& bvh) -> size_t
+{
+    sim::set_simd_level(level);
+    auto counters = Counters{};
+    for (size_t trial = 0; trial < trials_per_level; ++trial)
+    {
+        auto const batch = random_batch();
+        for (auto const& segment : obstacles.segments)
+        {
+            check_kernel("segment_intersect_batch", batch, segment, sim::segment_intersect_batch, scalar_segment_intersect, counters);
+        }
+        for (auto const& circle : obstacles.circles)
+        {
+            check_kernel("segment_circle_intersect_batch", batch, circle, sim::segment_circle_intersect_batch, scalar_circle_intersect, counters);
+        }
+
+        auto hits = std::array<std::optional<sim::Hit>, sim::max_batch_size>{};
+        bvh.closest_hits(batch.paths(), batch.count, hits.data());
+        for (size_t i = 0; i < batch.count; ++i)
+            counters.record(same_hit(hits[i], bvh.closest_hit(batch.start(i), batch.end(i))), "ColliderBVH::closest_hits", batch.start(i), batch.end(i));
+    }
+    std::printf("%s: %zu tests, %zu hits, %zu mismatches\n", sim::to_string(level), counters.tests, counters.hits, counters.mismatches);
+    return counters.mismatches;
+}
+
+} // namespace
+
+auto main() -> int
+{
+    sim::seed_random(1);
+    auto const obstacles = random_obstacles();
+    auto const bvh       = sim::ColliderBVH{obstacles};
+
+    size_t     mismatches = 0;
+    auto const detected   = sim::detected_simd_level();
+    for (int level = static_cast<int>(sim::SimdLevel::Scalar); level <= static_cast<int>(detected); ++level)
+        mismatches += check_level(static_cast<sim::SimdLevel>(level), obstacles, bvh);
+    sim::set_simd_level(detected);
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
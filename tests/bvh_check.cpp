@@ -0,0 +1,92 @@
+// Checks that ColliderBVH::closest_hit() finds exactly the same hits as testing every obstacle with sim::closest_hit(),
+// on random scenes of various sizes. Prints the first mismatches and exits with a non-zero code if there is any.
+//
+// Usage: Particles-bvh-check
+
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include "simulation/ColliderBVH.hpp"
+#include "simulation/collision.hpp"
+#include "simulation/random.hpp"
+
+namespace {
+
+constexpr size_t paths_per_scene = 50'000;
+constexpr size_t max_reported    = 10;
+
+auto random_point() -> glm::vec2
+{
+    return {sim::rand(-2.f, 2.f), sim::rand(-1.f, 1.f)};
+}
+
+/// Short obstacles scattered over the whole scene, like the ones the app builds
+auto random_obstacles(size_t segments_count, size_t circles_count) -> sim::Obstacles
+{
+    auto obstacles = sim::Obstacles{};
+    for (size_t i = 0; i < segments_count; ++i)
+    {
+        auto const start = random_point();
+        obstacles.segments.push_back({start, start + glm::vec2{sim::rand(-0.05f, 0.05f), sim::rand(-0.05f, 0.05f)}});
+    }
+    for (size_t i = 0; i < circles_count; ++i)
+        obstacles.circles.push_back({random_point(), sim::rand(0.01f, 0.1f)});
+    return obstacles;
+}
+
+auto same_hit(std::optional<sim::Hit> const& a, std::optional<sim::Hit> const& b) -> bool
+{
+    if (!a || !b)
+        return a.has_value() == b.has_value();
+    return a->obstacle_id == b->obstacle_id
+           && a->point == b->point
+           && a->normal == b->normal
+           && a->distance_squared == b->distance_squared;
+}
+
+/// Returns the number of paths for which the BVH and the brute force disagree
+auto check_scene(size_t segments_count, size_t circles_count) -> size_t
+{
+    auto const obstacles       = random_obstacles(segments_count, circles_count);
+    auto const bvh             = sim::ColliderBVH{obstacles};
+    auto const obstacles_count = static_cast<uint32_t>(segments_count + circles_count);
+
+    size_t hits_count = 0;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < paths_per_scene; ++i)
+    {
+        auto const start = random_point();
+        auto const end   = start + glm::vec2{sim::rand(-0.05f, 0.05f), sim::rand(-0.05f, 0.05f)};
+        // Like after a bounce, where the obstacle that was just hit is ignored
+        auto const ignored = (i % 4 == 0 && obstacles_count != 0) ? static_cast<uint32_t>(i) % obstacles_count : sim::no_obstacle;
+
+        auto const expected = sim::closest_hit(start, end, obstacles, ignored);
+        auto const actual   = bvh.closest_hit(start, end, ignored);
+        hits_count += expected.has_value();
+        if (same_hit(expected, actual))
+            continue;
+
+        if (++mismatches <= max_reported)
+        {
+            std::fprintf(stderr, "Mismatch for the path (%g, %g) -> (%g, %g): expected obstacle %d, got %d\n",
+                         start.x, start.y, end.x, end.y,
+                         expected ? static_cast<int>(expected->obstacle_id) : -1,
+                         actual ? static_cast<int>(actual->obstacle_id) : -1);
+        }
+    }
+    std::printf("%zu segments, %zu circles: %zu hits, %zu mismatches\n", segments_count, circles_count, hits_count, mismatches);
+    return mismatches;
+}
+
+} // namespace
+
+auto main() -> int
+{
+    sim::seed_random(1);
+
+    size_t mismatches = 0;
+    for (size_t const segments_count : {0, 1, 3, 9, 100, 5000})
+        mismatches += check_scene(segments_count, segments_count / 3);
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
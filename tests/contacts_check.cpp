@@ -0,0 +1,42 @@
+// Checks how step_particle() handles a particle that bounces max_contacts_per_step times during a single step,
+// between two parallel walls 1 unit apart: it must go on with the rest of the way when that is free, and stop at its last contact otherwise.
+//
+// Usage: Particles-contacts-check
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "simulation/collision.hpp"
+#include "simulation/update.hpp"
+
+namespace {
+
+auto walls() -> sim::Obstacles
+{
+    return {.segments = {{{-100.f, 0.f}, {100.f, 0.f}}, {{-100.f, 1.f}, {100.f, 1.f}}}};
+}
+
+/// Starts halfway between the walls and moves up by `distance` in a single step
+auto check(char const* name, float distance, glm::vec2 const& expected_position, glm::vec2 const& expected_velocity) -> bool
+{
+    auto position = glm::vec2{0.f, 0.5f};
+    auto velocity = glm::vec2{0.f, distance};
+    sim::step_particle(position, velocity, 1.f, walls());
+
+    float constexpr tolerance = 1e-3f; // Each bounce happens contact_offset away from the wall
+    bool const ok             = glm::length(position - expected_position) < tolerance && velocity == expected_velocity;
+    std::printf("%s: position (%g, %g), velocity (%g, %g): %s\n", name, position.x, position.y, velocity.x, velocity.y, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+} // namespace
+
+auto main() -> int
+{
+    static_assert(sim::max_contacts_per_step == 8, "The distances below are made for 8 contacts");
+    // 8 contacts, 0.5 after the first one and then 1 between each, leave 0.25 of free way
+    bool ok = check("Free after the last contact", 7.75f, {0.f, 0.25f}, {0.f, 7.75f});
+    // 1.5 of way left after the 8th contact, that cross the top wall again: stops at the 8th contact, on the bottom wall
+    ok &= check("Blocked after the last contact", 9.f, {0.f, 0.f}, {0.f, 9.f});
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,97 @@
+// Checks that both GPU backends, GpuParticleSystem (compute shaders) and TransformFeedbackParticleSystem, move the particles and make them bounce
+// like sim::step_particle() does on the CPU. Fast particles over the star scene bounce several times during the run.
+// Prints the largest distance between the GPU and CPU positions, and exits with a non-zero code if it is above the tolerance.
+// Needs an OpenGL context: when none can be created (e.g. on a build machine without a display), exits with skipped_exit_code. Run with LIBGL_ALWAYS_SOFTWARE=1 to use Mesa's llvmpipe on machines without a GPU.
+//
+// Usage: Particles-gpu-particles-check
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <vector>
+#include "GpuParticleSystem.hpp"
+#include "TransformFeedbackParticleSystem.hpp"
+#include "opengl-framework/opengl-framework.hpp"
+#include "simulation/Particle.hpp"
+#include "simulation/random.hpp"
+#include "simulation/scene.hpp"
+#include "simulation/update.hpp"
+
+namespace {
+
+constexpr int    skipped_exit_code = 77; // What CTest reports as skipped, see SKIP_RETURN_CODE in CMakeLists.txt
+constexpr size_t particles_count   = 100'000;
+constexpr int    steps_count       = 10;
+constexpr float  dt                = 1.f / 30.f;
+constexpr float  aspect_ratio      = 16.f / 9.f;
+/// The GPU doesn't round exactly like the CPU, and each bounce carries the difference over. It stays around 1e-4 after steps_count steps.
+constexpr float tolerance = 1e-3f;
+
+auto make_particles() -> std::vector<sim::Particle>
+{
+    sim::seed_random(1);
+    auto particles = std::vector<sim::Particle>{};
+    particles.reserve(particles_count);
+    for (size_t i = 0; i < particles_count; ++i)
+    {
+        auto particle = sim::random_particle(aspect_ratio);
+        particle.velocity *= 20.f;  // So that they bounce a lot, several times per step for some of them
+        particle.lifetime = 1e9f;   // Respawns draw different random numbers on the GPU, so none must happen
+        particles.push_back(particle);
+    }
+    return particles;
+}
+
+/// Returns true iff the GPU positions stay within the tolerance of the CPU ones at every step
+template<typename GpuSystem>
+auto check_backend(char const* name, std::vector<sim::Particle> const& particles, sim::Obstacles const& obstacles) -> bool
+{
+    auto gpu = GpuSystem{{.obstacles = obstacles, .particles = particles, .spawn_half_size = {aspect_ratio, 1.f}}};
+    auto cpu = particles;
+
+    float max_distance = 0.f;
+    for (int step = 0; step < steps_count; ++step)
+    {
+        gpu.update(dt);
+        for (auto& particle : cpu)
+        {
+            particle.age += dt;
+            sim::step_particle(particle.position, particle.velocity, dt, obstacles);
+        }
+
+        auto const gpu_particles = gpu.read_particles();
+        for (size_t i = 0; i < cpu.size(); ++i)
+            max_distance = std::max(max_distance, glm::length(gpu_particles[i].position - cpu[i].position));
+    }
+
+    bool const ok = max_distance <= tolerance;
+    std::printf("%s: largest distance to the CPU after %d steps: %g (tolerance %g): %s\n", name, steps_count, max_distance, tolerance, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+} // namespace
+
+auto main() -> int
+{
+    try
+    {
+        gl::init("Particles GPU check");
+    }
+    catch (std::exception const&)
+    {
+        std::printf("Could not create an OpenGL context: skipped\n");
+        return skipped_exit_code;
+    }
+
+    auto const obstacles = sim::star_obstacles(aspect_ratio);
+    auto const particles = make_particles();
+
+    bool ok = true;
+    if (utils::GpuParticleSystem::is_supported())
+        ok &= check_backend<utils::GpuParticleSystem>("Compute shaders", particles, obstacles);
+    else
+        std::printf("Compute shaders: not supported by this OpenGL context, skipped\n");
+    ok &= check_backend<utils::TransformFeedbackParticleSystem>("Transform feedback", particles, obstacles);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}